@@ -13,6 +13,15 @@ struct add_args
 
 static const char* host = "localhost";
 
+namespace ipc
+{
+    template <>
+    struct cacheable_call<(uint32_t)simple_server_function_t::add>
+    {
+        static const bool value = true;
+    };
+}
+
 static bool dispatch(uint32_t id, ipc::in_message& in_msg, ipc::out_message& out_msg)
 {
     switch ((simple_client_function_t)id)
@@ -45,10 +54,27 @@ int main()
         auto result = ipc::service_invoker().call_by_address<(uint32_t)simple_server_function_t::add_with_callbacks, int32_t>(std::tuple{ host, port }, dispatch, minimal_predicate, ipc::message::remote_ptr<true>(&args));
         std::cout << "add(" << args.a << ", " << args.b << ") = " << result << std::endl;
 
+        result = ipc::service_invoker().call_by_address<(uint32_t)simple_server_function_t::add_with_remote_read, int32_t>(std::tuple{ host, port }, minimal_dispatch, minimal_predicate, ipc::readable_ptr(&args));
+        std::cout << "add(" << args.a << ", " << args.b << ") = " << result << std::endl;
+
         int32_t a = 7, b = 8;
         result = ipc::service_invoker().call_by_address<(uint32_t)simple_server_function_t::add, int32_t>(std::tuple{ host, port }, minimal_dispatch, minimal_predicate, a, b);
         std::cout << "add(" << a << ", " << b << ") = " << result << std::endl;
 
+        ipc::load_balancer<std::tuple<const char*, uint16_t>> balancer({ { host, port }, { "127.0.0.1", port } });
+        result = ipc::service_invoker().call_by_balancer<(uint32_t)simple_server_function_t::add, int32_t>(balancer, minimal_dispatch, minimal_predicate, a, b);
+        std::cout << "add(" << a << ", " << b << ") = " << result << std::endl;
+
+        result = ipc::service_invoker().call_hedged<(uint32_t)simple_server_function_t::add, int32_t>(balancer, 0.95, minimal_dispatch, minimal_predicate, a, b);
+        std::cout << "add(" << a << ", " << b << ") = " << result << std::endl;
+
+        ipc::call_cache cache(1 << 16, std::chrono::seconds(1));
+        for (int i = 0; i < 2; ++i) // the second call is answered by cache
+        {
+            result = ipc::service_invoker(cache).call_by_address<(uint32_t)simple_server_function_t::add, int32_t>(std::tuple{ host, port }, minimal_dispatch, minimal_predicate, a, b);
+            std::cout << "add(" << a << ", " << b << ") = " << result << std::endl;
+        }
+
         return 0;
     }
     catch (const std::exception& ex)
@@ -2,6 +2,7 @@ enum class simple_server_function_t
 {
 	add_with_callbacks = 0,
 	add,
+	add_with_remote_read,
 
 	unknown
 };
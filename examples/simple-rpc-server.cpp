@@ -42,6 +42,12 @@ static void signal_handler(int /*signum*/) noexcept
 
 auto predicate = []() { return !g_stop; };
 
+struct add_args
+{
+    int32_t a;
+    int32_t b;
+};
+
 class dispatcher
 {
 public:
@@ -60,11 +66,28 @@ public:
         case simple_server_function_t::add:
             ipc::function_invoker<int32_t(int32_t, int32_t), true>()(in_msg, out_msg, [](int32_t arg1, int32_t arg2) -> int32_t { return arg1 + arg2; });
             break;
+        case simple_server_function_t::add_with_remote_read:
+            ipc::function_invoker<int32_t(ipc::message::remote_ptr<true>), true>()(in_msg, out_msg, [&p2p_socket, &in_msg, &out_msg](const ipc::message::remote_ptr<true>& p) mutable -> int32_t {
+                auto [args] = ipc::service_invoker().read_by_channel<add_args>(p2p_socket, in_msg, out_msg, predicate, p);
+
+                return args.a + args.b;
+                });
+            break;
         default:
             break;
         }
     }
 
+    bool is_idempotent(uint32_t id) const
+    {
+        return ((simple_server_function_t)id == simple_server_function_t::add);
+    }
+
+    std::chrono::milliseconds response_ttl(uint32_t id) const
+    {
+        return ((simple_server_function_t)id == simple_server_function_t::add) ? std::chrono::seconds(1) : std::chrono::milliseconds::zero();
+    }
+
     void report_error(const std::exception_ptr& p) const
     {
         if (!g_stop)
@@ -94,6 +117,7 @@ int main()
         install_signal_handlers(signal_handler);
 
         ipc::rpc_server<ipc::tcp_server_socket> server(port);
+        server.enable_response_cache(1 << 20);
         server.run(dispatcher(), predicate);
     }
     catch(const std::exception& ex) 
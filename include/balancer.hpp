@@ -0,0 +1,279 @@
+/**
+ * \file balancer.hpp
+ *
+ * \brief Additional IPC library components (client side load balancing). 
+ *
+ * \copyright Copyright (C) 2020 Pavel Kovalenko. All rights reserved.<br>
+ * <br>
+ * This Source Code Form is subject to the terms of the Mozilla<br>
+ * Public License, v. 2.0. If a copy of the MPL was not distributed<br>
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#ifndef __DOXYGEN__
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif // __DOXYGEN__
+
+#include "ipc.hpp"
+
+namespace ipc
+{
+    /**
+     * \brief Endpoint selection policy of ipc::load_balancer.
+     */
+    enum class balancing_policy
+    {
+        least_outstanding, ///< endpoint with less outstanding requests wins (observed latency breaks ties)
+        least_latency ///< endpoint with less observed latency wins (outstanding requests break ties)
+    };
+
+    /**
+     * \brief Thread safe per endpoint circuit breaker.
+     *
+     * Breaker is closed (calls are allowed) while endpoint works. Several failures in a row open it: calls are rejected immediately during open time. 
+     * After that the single trial call is allowed (half open state): its success closes breaker, its failure opens breaker again. Successful background 
+     * probe (see ipc::load_balancer) finishes open time early.
+     */
+    class circuit_breaker
+    {
+    public:
+        typedef std::chrono::steady_clock clock; ///< clock used for open time measurement
+
+        /**
+         * \brief Breaker states.
+         */
+        enum class state_t : uint8_t
+        {
+            closed, ///< calls are allowed
+            open, ///< calls are rejected
+            half_open ///< trial call is running
+        };
+
+        /**
+         * \brief Creates closed breaker.
+         *
+         * \param failures_to_open number of failures in a row that opens breaker
+         * \param open_time duration of open state (and max duration of trial call)
+         */
+        explicit circuit_breaker(uint32_t failures_to_open = 3, clock::duration open_time = std::chrono::seconds(10)) noexcept : 
+            m_state(state_t::closed), m_failures(0), m_failures_to_open(std::max<uint32_t>(failures_to_open, 1)), m_open_time(open_time) {}
+
+        circuit_breaker(const circuit_breaker&) = delete;
+        circuit_breaker& operator = (const circuit_breaker&) = delete;
+
+        /**
+         * \brief Checks if call would be allowed (without state changing).
+         *
+         * \param now current time
+         */
+        bool is_available(clock::time_point now = clock::now()) const noexcept;
+
+        /**
+         * \brief Asks permission for call.
+         *
+         * \return true if call is allowed (its result must be reported by #report)
+         */
+        bool try_acquire() noexcept;
+
+        /**
+         * \brief Reports call result.
+         *
+         * \param success false if call failed because of endpoint (connection or transport failure)
+         */
+        void report(bool success) noexcept;
+
+        /**
+         * \brief Finishes open time (endpoint has been successfully probed), so the next call will be a trial.
+         */
+        void probe_succeeded() noexcept;
+
+        /**
+         * \brief Returns current state.
+         */
+        state_t get_state() const noexcept { return m_state.load(std::memory_order_acquire); }
+
+    protected:
+        mutable std::mutex m_lock; ///< state transitions lock
+        std::atomic<state_t> m_state; ///< current state
+        std::atomic<uint32_t> m_failures; ///< number of failures in a row
+        const uint32_t m_failures_to_open; ///< number of failures in a row that opens breaker
+        const clock::duration m_open_time; ///< duration of open state
+        clock::time_point m_deadline; ///< end of open state or trial call
+    };
+
+    /**
+     * \brief Thread safe client side load balancer.
+     *
+     * Balancer holds set of service addresses (the same tuples as ipc::service_invoker::call_by_address accepts) and selects one of them for each call by "power of two choices" rule: 
+     * two random healthy endpoints are compared by outstanding requests count or observed latency (see ipc::balancing_policy), the best of them is used.
+     * Each endpoint has its own ipc::circuit_breaker: endpoints that fail several calls in a row are ejected (passive health checking) for some time. If all endpoints 
+     * are ejected, ipc::circuit_open_exception is thrown immediately. Ejected endpoints can be probed by background thread: successful connection finishes ejection early.
+     * Balanced calls make single connection attempt (failing endpoints are handled by breakers instead of connection retries).
+     *
+     * \note Server closes connection after each request, so there are no connection pools: each call establishes new connection to selected endpoint.
+     *
+     * \tparam Tuple service address type
+     */
+    template <typename Tuple>
+    class load_balancer
+    {
+    protected:
+        struct endpoint;
+
+    public:
+        typedef std::chrono::steady_clock clock; ///< clock used for latency measurement and ejection
+        static constexpr int connect_attempts = 1; ///< number of connection attempts of balanced calls
+
+        /**
+         * \brief Endpoint usage guard.
+         *
+         * Lease counts outstanding request of endpoint while it exists. Call result should be reported by #complete, otherwise it is not taken into account.
+         */
+        class lease
+        {
+        public:
+            lease(const lease&) = delete;
+            lease& operator = (const lease&) = delete;
+            lease(lease&& other) noexcept : m_owner(other.m_owner), m_endpoint(other.m_endpoint), m_start(other.m_start) { other.m_endpoint = nullptr; }
+            ~lease() { release(); }
+
+            /**
+             * \brief Returns selected service address.
+             */
+            const Tuple& get_address() const noexcept { return m_endpoint->address; }
+
+            /**
+             * \brief Reports call result and releases endpoint.
+             *
+             * \param success false if call failed because of endpoint (connection or transport failure)
+             */
+            void complete(bool success) noexcept;
+
+        protected:
+            /**
+             * \brief Creates lease of endpoint.
+             *
+             * \param owner balancer
+             * \param e selected endpoint
+             */
+            lease(load_balancer& owner, endpoint& e) noexcept;
+
+            void release() noexcept; ///< releases endpoint without result reporting
+
+            load_balancer& m_owner; ///< balancer that owns endpoint
+            endpoint* m_endpoint; ///< selected endpoint
+            clock::time_point m_start; ///< lease creation time
+
+            friend class load_balancer;
+        };
+
+        /**
+         * \brief Creates balancer.
+         *
+         * \param addresses service endpoints addresses (must not be empty)
+         * \param policy endpoint selection policy
+         * \param failures_to_eject number of failures in a row that ejects endpoint
+         * \param ejection_time ejection duration
+         * \param probe_interval interval of ejected endpoints background probing (zero disables probing thread)
+         */
+        explicit load_balancer(const std::vector<Tuple>& addresses, balancing_policy policy = balancing_policy::least_outstanding, 
+            uint32_t failures_to_eject = 3, clock::duration ejection_time = std::chrono::seconds(10), clock::duration probe_interval = clock::duration::zero());
+
+        load_balancer(const load_balancer&) = delete;
+        load_balancer& operator = (const load_balancer&) = delete;
+
+        ~load_balancer(); ///< stops probing thread
+
+        /**
+         * \brief Selects endpoint for the next call.
+         *
+         * Throws ipc::circuit_open_exception if all endpoints are ejected.
+         *
+         * \return lease of selected endpoint
+         */
+        lease acquire();
+
+        /**
+         * \brief Selects endpoint for the next call except already leased one (if there are another endpoints).
+         *
+         * \param busy lease of endpoint to skip
+         *
+         * \return lease of selected endpoint
+         */
+        lease acquire_except(const lease& busy);
+
+        /**
+         * \brief Estimates latency percentile of recent successful calls (of all endpoints).
+         *
+         * \param percentile percentile in range [0, 1]
+         *
+         * \return latency estimation or zero if there are no successful calls yet
+         */
+        clock::duration get_latency_percentile(double percentile) const;
+
+        /**
+         * \brief Returns number of endpoints.
+         */
+        size_t size() const noexcept { return m_endpoints.size(); }
+
+    protected:
+        /**
+         * \brief Endpoint state.
+         */
+        struct endpoint
+        {
+            endpoint(const Tuple& a, uint32_t failures_to_eject, clock::duration ejection_time) : address(a), breaker(failures_to_eject, ejection_time) {}
+
+            const Tuple address; ///< service address
+            std::atomic<uint32_t> outstanding = 0; ///< number of running calls
+            std::atomic<int64_t> latency = 0; ///< exponentially weighted moving average of successful calls latency (in nanoseconds, approximate)
+            circuit_breaker breaker; ///< endpoint circuit breaker
+        };
+
+        /**
+         * \brief Compares endpoints according to balancing policy.
+         *
+         * \return true if \p a is better than \p b
+         */
+        bool is_better(const endpoint& a, const endpoint& b) const noexcept;
+
+        /**
+         * \brief Selects endpoint by "power of two choices" rule.
+         *
+         * \param busy endpoint to skip (can be nullptr)
+         */
+        endpoint& select(const endpoint* busy);
+
+        /**
+         * \brief Background probing thread routine.
+         *
+         * \param interval probing interval
+         */
+        void probe_proc(clock::duration interval);
+
+        static constexpr size_t latency_samples_count = 256; ///< number of recent latency samples
+
+        std::vector<std::unique_ptr<endpoint>> m_endpoints; ///< endpoints
+        balancing_policy m_policy; ///< endpoint selection policy
+        std::array<std::atomic<int64_t>, latency_samples_count> m_latency_samples = {}; ///< recent successful calls latency (ring buffer, in nanoseconds)
+        std::atomic<size_t> m_latency_samples_written = 0; ///< total number of written latency samples
+        std::mutex m_probe_lock; ///< #m_stop lock
+        std::condition_variable m_probe_wakeup; ///< probing thread stop signal
+        bool m_stop = false; ///< probing thread stop flag
+        std::thread m_prober; ///< probing thread (optional)
+    };
+}
+
+#ifndef __DOXYGEN__
+#include "../source/balancer_impl.hpp"
+#endif // __DOXYGEN__
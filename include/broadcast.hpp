@@ -0,0 +1,166 @@
+/**
+ * \file broadcast.hpp
+ *
+ * \brief Additional IPC library components (shared memory broadcast channel, POSIX only).
+ *
+ * \copyright Copyright (C) 2020 Pavel Kovalenko. All rights reserved.<br>
+ * <br>
+ * This Source Code Form is subject to the terms of the Mozilla<br>
+ * Public License, v. 2.0. If a copy of the MPL was not distributed<br>
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#ifndef __DOXYGEN__
+#include <atomic>
+#include <string>
+#include <string_view>
+#endif // __DOXYGEN__
+
+#include "ipc.hpp"
+
+#ifndef _WIN32
+namespace ipc
+{
+    /**
+     * \brief Broadcast channel file can't be created, mapped or read.
+     */
+    class broadcast_channel_exception : public system_error
+    {
+    public:
+        /**
+         * \brief Exception constructor
+         *
+         * \param code exception code (errno)
+         * \param message exception message
+         */
+        template <class T>
+        broadcast_channel_exception(int code, T&& message) : system_error(code, std::forward<T>(message)) {}
+    };
+
+    /**
+     * \brief Single producer side of shared memory broadcast ring.
+     *
+     * Serialized messages are copied once to memory mapped ring, and any number of local processes read them by ipc::broadcast_receiver,
+     * so publishing cost doesn't depend on number of receivers. Producer never waits for receivers: each receiver tracks its own position
+     * and detects overwritten data seqlock-style, receiver that falls behind by more than ring capacity loses the oldest messages.
+     *
+     * \note Only one producer (thread or process) may publish to channel. Use file on memory file system (e.g. /dev/shm) to avoid disk writes.
+     */
+    class broadcast_channel
+    {
+    public:
+        /**
+         * \brief Creates channel file (existing file is replaced) and maps it to memory.
+         *
+         * \param path channel file path
+         * \param capacity ring size (in bytes), it limits size of the longest message
+         */
+        broadcast_channel(std::string_view path, size_t capacity);
+        ~broadcast_channel(); ///< unmaps channel (file is kept for receivers)
+
+        broadcast_channel(const broadcast_channel&) = delete;
+        broadcast_channel& operator = (const broadcast_channel&) = delete;
+
+        /**
+         * \brief Publishes raw message.
+         *
+         * \param message raw message (size header included)
+         */
+        void publish(const char* message);
+
+        /**
+         * \brief Publishes message.
+         *
+         * \param message serialized message
+         */
+        void publish(const out_message& message) { publish(message.get_data().data()); }
+
+        /**
+         * \brief Returns number of published messages.
+         */
+        uint64_t get_published_count() const noexcept;
+
+    protected:
+        struct header; ///< channel file header
+        struct record; ///< message record header
+
+        /**
+         * \brief Writes record to ring (reserved range is announced to receivers before writing).
+         *
+         * \param size record size (header and alignment included)
+         * \param message raw message (nullptr means padding till the end of ring)
+         */
+        void write_record(size_t size, const char* message) noexcept;
+
+        std::string m_path; ///< channel file path
+        int m_file; ///< channel file descriptor
+        size_t m_size; ///< mapped size (header included)
+        char* m_data; ///< mapped channel
+        uint64_t m_position; ///< absolute position of the next record
+        uint64_t m_oldest; ///< absolute position of the oldest intact record
+
+        friend class broadcast_receiver;
+    };
+
+    /**
+     * \brief Receiver of messages published by ipc::broadcast_channel.
+     *
+     * Receiver starts from the next published message. Each message is copied to ipc::in_message and validated after copying,
+     * so data that has been overwritten by producer during reading is never returned.
+     */
+    class broadcast_receiver
+    {
+    public:
+        /**
+         * \brief Maps channel file to memory.
+         *
+         * \param path channel file path
+         */
+        explicit broadcast_receiver(std::string_view path);
+        ~broadcast_receiver(); ///< unmaps channel
+
+        broadcast_receiver(const broadcast_receiver&) = delete;
+        broadcast_receiver& operator = (const broadcast_receiver&) = delete;
+
+        /**
+         * \brief Reads the next message if it is available.
+         *
+         * \param message message object
+         *
+         * \return false if there are no new messages
+         */
+        bool try_receive(in_message& message);
+
+        /**
+         * \brief Waits for the next message (by polling, thread yields between attempts).
+         *
+         * \p predicate may be called several times to ask if the function should continue waiting for message. If \p predicate returns false function
+         * will throw ipc::user_stop_request_exception.
+         *
+         * \param message message object
+         * \param predicate function of type bool() or similar callable object
+         */
+        template <typename Predicate>
+        void receive(in_message& message, const Predicate& predicate);
+
+        /**
+         * \brief Returns number of messages that have been overwritten before receiving.
+         */
+        uint64_t get_lost_count() const noexcept { return m_lost; }
+
+    protected:
+        size_t m_size; ///< mapped size
+        size_t m_capacity; ///< ring size
+        const char* m_data; ///< mapped channel
+        uint64_t m_position; ///< absolute position of the next record
+        uint64_t m_sequence; ///< sequence number of the next message (unknown before the first message)
+        uint64_t m_lost = 0; ///< number of lost messages
+    };
+}
+
+#ifndef __DOXYGEN__
+#include "../source/broadcast_impl.hpp"
+#endif // __DOXYGEN__
+#endif // _WIN32
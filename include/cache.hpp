@@ -0,0 +1,206 @@
+/**
+ * \file cache.hpp
+ *
+ * \brief Additional IPC library components (serialized messages caching). 
+ *
+ * \copyright Copyright (C) 2020 Pavel Kovalenko. All rights reserved.<br>
+ * <br>
+ * This Source Code Form is subject to the terms of the Mozilla<br>
+ * Public License, v. 2.0. If a copy of the MPL was not distributed<br>
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#ifndef __DOXYGEN__
+#include <chrono>
+#include <future>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#endif // __DOXYGEN__
+
+#include "ipc.hpp"
+
+namespace ipc
+{
+    /**
+     * \brief Thread safe sharded LRU cache of serialized messages.
+     *
+     * Keys are request payloads (message without size header and trace context, see ipc::in_message::get_payload), values are raw response frames 
+     * (size header included), so cache hit doesn't require any serialization. Each entry has its own time to live. 
+     * Memory used by keys and values is limited: least recently used entries of a shard are evicted when shard limit (total limit divided by shards count) is exceeded.
+     */
+    class response_cache
+    {
+    public:
+        typedef std::shared_ptr<const std::vector<char>> frame_ptr; ///< immutable serialized frame shared between cache and its users
+        typedef std::chrono::steady_clock clock; ///< clock used for entries expiration
+
+        /**
+         * \brief Creates empty cache.
+         *
+         * \param max_memory total memory limit for keys and values (in bytes)
+         * \param shards_count number of independently locked cache parts
+         */
+        explicit response_cache(size_t max_memory, size_t shards_count = 16);
+
+        response_cache(const response_cache&) = delete;
+        response_cache& operator = (const response_cache&) = delete;
+
+        /**
+         * \brief Looks for unexpired entry and marks it as most recently used.
+         *
+         * \param key serialized request payload
+         *
+         * \return cached frame or nullptr
+         */
+        frame_ptr find(std::string_view key);
+
+        /**
+         * \brief Stores (or replaces) entry.
+         *
+         * Entries that are larger than shard limit are not stored.
+         *
+         * \param key serialized request payload
+         * \param frame serialized response
+         * \param ttl entry time to live
+         */
+        void insert(std::string key, frame_ptr frame, clock::duration ttl);
+
+        /**
+         * \brief Removes all entries.
+         */
+        void clear() noexcept;
+
+        /**
+         * \brief Returns memory used by keys and values.
+         */
+        size_t get_memory_usage() noexcept;
+
+    protected:
+        /**
+         * \brief Cache entry.
+         */
+        struct entry
+        {
+            std::string key; ///< serialized request payload
+            frame_ptr frame; ///< serialized response
+            clock::time_point expiration; ///< expiration time
+        };
+
+        /**
+         * \brief Independently locked part of cache.
+         */
+        struct shard
+        {
+            std::mutex lock; ///< shard lock
+            std::list<entry> lru; ///< entries ordered from most to least recently used
+            std::unordered_map<std::string_view, std::list<entry>::iterator> index; ///< entries index (keys are views of entry::key)
+            size_t used = 0; ///< memory used by shard entries
+        };
+
+        /**
+         * \brief Gets shard that holds \p key.
+         *
+         * \param key serialized request payload
+         */
+        shard& get_shard(std::string_view key) noexcept;
+
+        /**
+         * \brief Removes entry from shard (shard must be locked).
+         *
+         * \param s shard
+         * \param it entry to remove
+         */
+        static void erase(shard& s, std::list<entry>::iterator it) noexcept;
+
+        /**
+         * \brief Calculates memory used by entry.
+         *
+         * \param key_size serialized request payload size
+         * \param frame_size serialized response size
+         */
+        static constexpr size_t entry_size(size_t key_size, size_t frame_size) noexcept { return key_size + frame_size + sizeof(entry); }
+
+        std::unique_ptr<shard[]> m_shards; ///< cache parts
+        size_t m_shards_count; ///< number of cache parts
+        size_t m_shard_limit; ///< memory limit per shard
+    };
+
+    /**
+     * \brief Concurrent identical calls coalescing helper.
+     *
+     * Only one of concurrent calls with the same key (leader) is executed, other callers (followers) wait for leader's result and share it. 
+     * Leader's exception is rethrown to all followers too.
+     */
+    class single_flight
+    {
+    public:
+        typedef response_cache::frame_ptr frame_ptr; ///< immutable serialized frame shared between callers
+
+        single_flight() = default;
+        single_flight(const single_flight&) = delete;
+        single_flight& operator = (const single_flight&) = delete;
+
+        /**
+         * \brief Executes \p producer or waits for result of running call with the same key.
+         *
+         * \param key call key (serialized request for example)
+         * \param producer function (or function-like object) compatible with frame_ptr()
+         *
+         * \return call result
+         */
+        template <typename Producer>
+        frame_ptr run(std::string key, Producer&& producer);
+
+    protected:
+        std::mutex m_lock; ///< #m_calls lock
+        std::unordered_map<std::string, std::shared_future<frame_ptr>> m_calls; ///< running calls
+    };
+
+    /**
+     * \brief Memoization cache of remote calls results.
+     *
+     * This class joins ipc::response_cache and ipc::single_flight: results are looked up in the cache first, concurrent identical cache misses are coalesced and produce single remote call.
+     */
+    class call_cache
+    {
+    public:
+        typedef response_cache::frame_ptr frame_ptr; ///< immutable serialized frame shared between cache and its users
+
+        /**
+         * \brief Creates empty cache.
+         *
+         * \param max_memory total memory limit for keys and values (in bytes)
+         * \param ttl entries time to live
+         * \param shards_count number of independently locked cache parts
+         */
+        call_cache(size_t max_memory, response_cache::clock::duration ttl, size_t shards_count = 16) : m_cache(max_memory, shards_count), m_ttl(ttl) {}
+
+        /**
+         * \brief Gets cached call result or executes \p producer (once for all concurrent callers) and caches its result.
+         *
+         * \param key call key
+         * \param producer function (or function-like object) compatible with frame_ptr()
+         *
+         * \return call result
+         */
+        template <typename Producer>
+        frame_ptr get(std::string key, Producer&& producer);
+
+        /**
+         * \brief Removes all cached results.
+         */
+        void clear() noexcept { m_cache.clear(); }
+
+    protected:
+        response_cache m_cache; ///< results cache
+        single_flight m_flights; ///< running calls
+        response_cache::clock::duration m_ttl; ///< results time to live
+    };
+}
+
+#ifndef __DOXYGEN__
+#include "../source/cache_impl.hpp"
+#endif // __DOXYGEN__
@@ -0,0 +1,141 @@
+/**
+ * \file capture.hpp
+ *
+ * \brief Additional IPC library components (wire capture, POSIX only).
+ *
+ * \copyright Copyright (C) 2020 Pavel Kovalenko. All rights reserved.<br>
+ * <br>
+ * This Source Code Form is subject to the terms of the Mozilla<br>
+ * Public License, v. 2.0. If a copy of the MPL was not distributed<br>
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#ifndef __DOXYGEN__
+#include <atomic>
+#include <string>
+#include <string_view>
+#endif // __DOXYGEN__
+
+#include "ipc.hpp"
+
+#ifndef _WIN32
+namespace ipc
+{
+    /**
+     * \brief Capture log file can't be created, mapped or read.
+     */
+    class capture_log_exception : public system_error
+    {
+    public:
+        /**
+         * \brief Exception constructor
+         *
+         * \param code exception code (errno)
+         * \param message exception message
+         */
+        template <class T>
+        capture_log_exception(int code, T&& message) : system_error(code, std::forward<T>(message)) {}
+    };
+
+    /**
+     * \brief Captured message.
+     */
+    struct capture_record
+    {
+        uint64_t connection_id; ///< connection identifier
+        int64_t timestamp; ///< capture time (nanoseconds since system clock epoch)
+        bool written; ///< true if message has been written by capturing side, false if it has been read
+        std::string_view message; ///< raw message (size header included)
+    };
+
+    /**
+     * \brief Thread and process safe memory mapped log of captured messages.
+     *
+     * Log file has fixed capacity: messages are appended by atomic reservation of log space, so concurrent writers (threads or forked processes) don't block each other.
+     * If log is full, messages are dropped (and counted). On destruction file is truncated to the used size.
+     * Log can be attached to ipc::point_to_point_socket (see ipc::point_to_point_socket::set_capture) or to ipc::rpc_server (see ipc::rpc_server::enable_capture).
+     */
+    class capture_log
+    {
+    public:
+        /**
+         * \brief Creates (or truncates) log file and maps it to memory.
+         *
+         * \param path log file path
+         * \param capacity max size of captured data (in bytes)
+         */
+        capture_log(std::string_view path, size_t capacity);
+        ~capture_log(); ///< unmaps log and truncates file to the used size
+
+        capture_log(const capture_log&) = delete;
+        capture_log& operator = (const capture_log&) = delete;
+
+        /**
+         * \brief Appends message to log.
+         *
+         * \param connection_id connection identifier
+         * \param message raw message (size header included)
+         * \param written true if message has been written, false if it has been read
+         *
+         * \return false if log is full and message has been dropped
+         */
+        bool append(uint64_t connection_id, const char* message, bool written) noexcept;
+
+        /**
+         * \brief Returns new unique connection identifier.
+         */
+        uint64_t make_connection_id() noexcept;
+
+        /**
+         * \brief Returns number of dropped messages.
+         */
+        uint64_t get_dropped_count() const noexcept;
+
+    protected:
+        struct header; ///< log file header
+        struct record; ///< message record header
+
+        std::string m_path; ///< log file path
+        int m_file; ///< log file descriptor
+        size_t m_size; ///< mapped size (header included)
+        char* m_data; ///< mapped log
+
+        friend class capture_reader;
+    };
+
+    /**
+     * \brief Sequential reader of log written by ipc::capture_log.
+     */
+    class capture_reader
+    {
+    public:
+        /**
+         * \brief Maps log file to memory.
+         *
+         * \param path log file path
+         */
+        explicit capture_reader(std::string_view path);
+        ~capture_reader(); ///< unmaps log
+
+        capture_reader(const capture_reader&) = delete;
+        capture_reader& operator = (const capture_reader&) = delete;
+
+        /**
+         * \brief Reads next captured message (incompletely written messages are skipped).
+         *
+         * \param r read message (its data is valid while reader exists)
+         *
+         * \return false if there are no more messages
+         */
+        bool next(capture_record& r) noexcept;
+
+    protected:
+        size_t m_size; ///< mapped size
+        size_t m_end; ///< end of used data
+        size_t m_offset; ///< next record offset
+        char* m_data; ///< mapped log
+    };
+}
+#endif // _WIN32
@@ -15,7 +15,10 @@
 #ifndef __DOXYGEN__
 
 #include <array>
+#include <cstddef>
 #include <limits>
+#include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <string>
 #include <string_view>
@@ -38,6 +41,7 @@
 #   include <unistd.h>
 #   include <sys/types.h>
 #   include <sys/socket.h>
+#   include <sys/uio.h>
 #   include <sys/un.h>
 #   define PATH_SEP '/'
 #   define stricmp strcasecmp
@@ -68,7 +72,7 @@
 #ifndef __MSG_LENGTH_TYPE__
 #   define __MSG_LENGTH_TYPE__ uint16_t
 #else
-    static_assert(std::is_unsigned_v(__MSG_LENGTH_TYPE__) && sizeof(__MSG_LENGTH_TYPE__) <= sizeof(size_t), "__MSG_LENGTH_TYPE__ must be unsigned integral type less or equal size_t");
+    static_assert(std::is_unsigned_v<__MSG_LENGTH_TYPE__> && sizeof(__MSG_LENGTH_TYPE__) <= sizeof(size_t), "__MSG_LENGTH_TYPE__ must be unsigned integral type less or equal size_t");
 #endif // __MSG_LENGTH_TYPE__
 
 #ifdef max
@@ -88,6 +92,52 @@
     static const size_t msg_max_length = __MSG_MAX_LENGTH__;
 #endif // __MSG_MAX_LENGTH__
 
+/**
+* \brief Trace context usage control macro.
+* 
+* Set __MSG_USE_TRACING__ to 1 to carry ipc::trace_context in header of each message (it increases message overhead by 17 bytes) and to record spans of remote calls (see trace.hpp).
+* Both sides of channel must use the same value. __MSG_USE_TRACING__ is 0 by default.
+*/
+#ifndef __MSG_USE_TRACING__
+#define __MSG_USE_TRACING__ 0
+#endif // __MSG_USE_TRACING__
+
+/**
+* \brief String encoding control macro.
+* 
+* Strings are serialized as zero terminated character sequences by default (wire format of previous library versions).
+* Set __MSG_LEGACY_STRINGS__ to 0 to serialize strings with __MSG_LENGTH_TYPE__ length prefix, so they are extracted without scanning and can contain zero characters.
+* 
+* \warning Encodings are incompatible and are not negotiated on the wire: both sides of channel must use the same value, otherwise strings are misparsed.
+* Switch to 0 only after all peers are rebuilt with it. __MSG_LEGACY_STRINGS__ is 1 by default.
+*/
+#ifndef __MSG_LEGACY_STRINGS__
+#define __MSG_LEGACY_STRINGS__ 1
+#endif // __MSG_LEGACY_STRINGS__
+
+/**
+* \brief Inline message storage size control macro.
+* 
+* Output messages up to __MSG_INLINE_SIZE__ bytes are stored inside message object, larger ones are moved to heap. __MSG_INLINE_SIZE__ is 64 by default.
+*/
+#ifndef __MSG_INLINE_SIZE__
+#define __MSG_INLINE_SIZE__ 64
+#endif // __MSG_INLINE_SIZE__
+
+/**
+* \brief Segment size control macro of ipc::segmented_out_message.
+* 
+* Segmented messages are built of fixed size memory blocks of __MSG_SEGMENT_SIZE__ bytes. __MSG_SEGMENT_SIZE__ is 16384 by default.
+*/
+#ifndef __MSG_SEGMENT_SIZE__
+#define __MSG_SEGMENT_SIZE__ 16384
+#endif // __MSG_SEGMENT_SIZE__
+
+#include "trace_context.hpp"
+#if __MSG_USE_TRACING__
+#include "trace.hpp"
+#endif // __MSG_USE_TRACING__
+
 /**
  * \brief IPC library namespace.
  */
@@ -222,6 +272,23 @@ namespace ipc
         explicit user_stop_request_exception(T&& message) : logic_error(std::forward<T>(message)) {}
     };
 
+    /**
+     * \brief Exception that will be thrown if call to unavailable service endpoint was rejected without connection attempt.
+     * 
+     * Client side circuit breakers (see ipc::circuit_breaker) reject calls to endpoints that have failed recently to avoid waiting for connection timeouts.
+     */
+    class circuit_open_exception : public logic_error
+    {
+    public:
+        /**
+         * \brief Exception constructor
+         *
+         * \param message exception message
+         */
+        template <class T>
+        explicit circuit_open_exception(T&& message) : logic_error(std::forward<T>(message)) {}
+    };
+
     /**
      * \brief Exception that will be thrown if container is not large enough to hold the serialized data object.
      * 
@@ -351,6 +418,22 @@ namespace ipc
         socket_read_exception(int code, T&& message) : active_socket_exception(code, std::forward<T>(message)) {}
     };
 
+    /**
+     * \brief Exception that was caused by connection closing before any data of message has been received.
+     */
+    class connection_closed_exception : public socket_read_exception
+    {
+    public:
+        /**
+         * \brief Exception constructor
+         *
+         * \param code exception code (errno or last error on Windows)
+         * \param message exception message
+         */
+        template <class T>
+        connection_closed_exception(int code, T&& message) : socket_read_exception(code, std::forward<T>(message)) {}
+    };
+
     /**
      * \brief Exception that was caused by host name to address translation error.
      */
@@ -438,6 +521,7 @@ namespace ipc
     {
     public:
         operator bool() const noexcept { return m_ok; } ///< checks socket internal state
+        socket_t get_handle() const noexcept { return m_socket; } ///< returns underlying socket handle (it is still owned by instance)
 
         socket(const socket&) = delete;
         socket& operator = (const socket&) = delete;
@@ -509,6 +593,173 @@ namespace ipc
     };
 #endif // __DOXYGEN__
 
+    /**
+     * \brief Returns memory resource that is used by messages created by current thread (heap by default, see ipc::request_arena::scope).
+     */
+    std::pmr::memory_resource* get_message_resource() noexcept;
+
+    /**
+     * \brief Monotonic memory arena of single request.
+     *
+     * While arena is active for thread (see ipc::request_arena::scope), messages created by this thread allocate their storage from arena 
+     * (as well as user's std::pmr containers created with ipc::get_message_resource), and the whole memory is released in one shot when scope ends.
+     * Arena keeps its initial block between requests, so typical requests don't use heap at all.
+     */
+    class request_arena
+    {
+    public:
+        /**
+         * \brief Creates arena.
+         *
+         * \param initial_size size of initial memory block (it is reused by all requests)
+         */
+        explicit request_arena(size_t initial_size = 16384);
+
+        request_arena(const request_arena&) = delete;
+        request_arena& operator = (const request_arena&) = delete;
+
+        /**
+         * \brief Returns arena memory resource.
+         */
+        std::pmr::memory_resource* get_resource() noexcept { return &m_resource; }
+
+        /**
+         * \brief Makes arena current memory resource of thread while instance exists.
+         *
+         * Messages and containers allocated from arena must not outlive scope.
+         */
+        class scope
+        {
+        public:
+            /**
+             * \brief Activates arena for current thread.
+             *
+             * \param arena request arena
+             */
+            explicit scope(request_arena& arena) noexcept;
+            ~scope(); ///< restores previous memory resource of thread and releases arena memory
+
+            scope(const scope&) = delete;
+            scope& operator = (const scope&) = delete;
+
+        protected:
+            request_arena& m_arena; ///< active arena
+            std::pmr::memory_resource* m_previous; ///< previous memory resource of thread
+        };
+
+    protected:
+        std::unique_ptr<char[]> m_initial; ///< initial memory block
+        std::pmr::monotonic_buffer_resource m_resource; ///< arena memory resource
+    };
+
+    /**
+     * \brief Byte buffer with small buffer optimization.
+     *
+     * Buffer uses inline storage of __MSG_INLINE_SIZE__ bytes until it grows larger, so small messages don't allocate memory. 
+     * Larger storage is allocated from memory resource of creating thread (see ipc::get_message_resource).
+     */
+    class message_buffer
+    {
+    public:
+        static constexpr size_t inline_capacity = __MSG_INLINE_SIZE__; ///< inline storage size
+
+        typedef char value_type; ///< element type
+        typedef char* iterator; ///< iterator type
+        typedef const char* const_iterator; ///< constant iterator type
+
+        message_buffer() noexcept : m_resource(get_message_resource()), m_data(m_inline.data()), m_size(0), m_capacity(inline_capacity) {} ///< creates empty buffer (inline storage is used)
+        message_buffer(message_buffer&& other) noexcept; ///< moves content (allocated storage and its memory resource are taken, inline one is copied)
+        message_buffer& operator = (message_buffer&& other) noexcept; ///< moves content (allocated storage and its memory resource are taken, inline one is copied)
+        ~message_buffer() { release(); } ///< releases allocated storage
+
+        message_buffer(const message_buffer&) = delete;
+        message_buffer& operator = (const message_buffer&) = delete;
+
+        char* data() noexcept { return m_data; } ///< returns pointer to content
+        const char* data() const noexcept { return m_data; } ///< returns pointer to content
+        size_t size() const noexcept { return m_size; } ///< returns content size
+        size_t capacity() const noexcept { return m_capacity; } ///< returns storage size
+        bool empty() const noexcept { return m_size == 0; } ///< checks if buffer is empty
+        bool is_inline() const noexcept { return m_data == m_inline.data(); } ///< checks if inline storage is used
+        std::pmr::memory_resource* get_resource() const noexcept { return m_resource; } ///< returns memory resource of allocated storage
+
+        iterator begin() noexcept { return m_data; } ///< returns iterator to content start
+        iterator end() noexcept { return m_data + m_size; } ///< returns iterator to content end
+        const_iterator begin() const noexcept { return m_data; } ///< returns iterator to content start
+        const_iterator end() const noexcept { return m_data + m_size; } ///< returns iterator to content end
+
+        char& operator [] (size_t index) noexcept { return m_data[index]; } ///< returns element reference
+        const char& operator [] (size_t index) const noexcept { return m_data[index]; } ///< returns element reference
+
+        /**
+         * \brief Makes storage at least \p capacity bytes long (content is preserved).
+         *
+         * \param capacity required storage size
+         */
+        void reserve(size_t capacity);
+
+        /**
+         * \brief Replaces content by \p count copies of \p value.
+         *
+         * \param count new content size
+         * \param value element value
+         */
+        void assign(size_t count, char value);
+
+        /**
+         * \brief Replaces content by range of elements.
+         *
+         * \param first range start
+         * \param last range end
+         */
+        void assign(const char* first, const char* last);
+
+        /**
+         * \brief Changes content size (content is preserved, new elements are not initialized).
+         *
+         * \param size new content size
+         */
+        void resize(size_t size);
+
+        /**
+         * \brief Releases unused storage (content is moved to inline storage if it fits).
+         */
+        void shrink_to_fit();
+
+        /**
+         * \brief Exchanges content (and allocated storages) of buffers.
+         *
+         * \param other buffer to exchange content with
+         */
+        void swap(message_buffer& other) noexcept;
+
+        /**
+         * \brief Appends element.
+         *
+         * \param value element value
+         */
+        void push_back(char value);
+
+        /**
+         * \brief Appends range of elements.
+         *
+         * \param first range start
+         * \param last range end
+         */
+        void append(const char* first, const char* last);
+
+        void clear() noexcept { m_size = 0; } ///< removes content (storage is kept)
+
+    protected:
+        void release() noexcept; ///< releases allocated storage and switches to inline one
+
+        std::pmr::memory_resource* m_resource; ///< memory resource of allocated storage
+        char* m_data; ///< current storage (inline or allocated)
+        size_t m_size; ///< content size
+        size_t m_capacity; ///< current storage size
+        alignas(std::max_align_t) std::array<char, inline_capacity> m_inline; ///< inline storage
+    };
+
     /**
      * \brief Base class for all messages hierarchy.
      *
@@ -573,6 +824,8 @@ namespace ipc
             friend class message;
         };
 
+        static constexpr size_t initial_read_size = message_buffer::inline_capacity; ///< initial size of receive buffer, it grows to the length of received message
+
         constexpr size_t get_max_size() const { return msg_max_length; } ///< returns max available message buffer size
         operator bool() const noexcept { return m_ok; } ///< checks message state
 
@@ -601,6 +854,20 @@ namespace ipc
             blob
         };
 
+#if __MSG_USE_TRACING__
+        static constexpr size_t trace_header_size = sizeof(uint64_t) * 2 + sizeof(uint8_t); ///< size of serialized ipc::trace_context
+#else
+        static constexpr size_t trace_header_size = 0; ///< size of serialized ipc::trace_context
+#endif // __MSG_USE_TRACING__
+        static constexpr size_t header_size = sizeof(__MSG_LENGTH_TYPE__) + trace_header_size; ///< message header size (length and trace context)
+#if __MSG_LEGACY_STRINGS__
+        static constexpr size_t string_prefix_size = 0; ///< size of serialized string length
+        static constexpr size_t string_suffix_size = 1; ///< size of serialized string terminator
+#else
+        static constexpr size_t string_prefix_size = sizeof(__MSG_LENGTH_TYPE__); ///< size of serialized string length
+        static constexpr size_t string_suffix_size = 0; ///< size of serialized string terminator
+#endif // __MSG_LEGACY_STRINGS__
+
 #ifdef __MSG_USE_TAGS__
         const char* to_string(type_tag t) noexcept; ///< gets text representation of tag
         constexpr bool is_compatible_tags(type_tag source, type_tag target) noexcept; ///< checks tags deserializing compatibility
@@ -617,9 +884,29 @@ namespace ipc
         template <typename T>
         friend struct tag_traits;
 
+        /**
+         * \brief Expected field of message (see ipc::in_message::validate).
+         */
+        struct field_signature
+        {
+            type_tag tag; ///< field type
+            size_t size; ///< data size of fixed size type or max length of string and blob
+        };
+
+        /**
+         * \brief Helper structure that is used to get #field_signature of given type (known is false for types that can't be validated).
+         */
+        template <typename T, typename = void>
+        struct field_traits
+        {
+            static constexpr bool known = false; ///< check result
+        };
+
         message() noexcept : m_ok(true) {}
         message(const message&) = delete;
         message& operator=(const message&) = delete;
+        message(message&&) noexcept = default;
+        message& operator=(message&&) noexcept = default;
 
         /**
          * \brief Gets ipc::remote_ptr<ConstPtr> internal storage value.
@@ -684,6 +971,15 @@ namespace ipc
          * \return message self reference 
          */
         out_message& operator << (const std::pair<const uint8_t*, size_t>& blob);
+
+        /**
+         * \brief Appends already serialized fields (e.g. unparsed tail of received message, see ipc::in_message::get_fields).
+         * 
+         * \param fields - serialized fields.
+         *
+         * \return message self reference 
+         */
+        out_message& append_fields(std::string_view fields);
         
         /**
          * \brief Resets message to empty state.
@@ -696,11 +992,70 @@ namespace ipc
          * Allocates buffer of minimal available size and clears object state.
          */
         out_message() { clear(); }
+
+        /**
+         * \brief Move constructor.
+         *
+         * Serialized data (and its storage) is taken from \p other, \p other is cleared.
+         * Storage allocated from ipc::request_arena must not outlive arena scope.
+         *
+         * \param other source message
+         */
+        out_message(out_message&& other) noexcept;
+
+        /**
+         * \brief Move assignment.
+         *
+         * Serialized data (and its storage) is taken from \p other, \p other is cleared.
+         *
+         * \param other source message
+         *
+         * \return message self reference 
+         */
+        out_message& operator = (out_message&& other) noexcept;
+
+        /**
+         * \brief Exchanges serialized data of messages (no memory is allocated).
+         *
+         * \param other message to exchange data with
+         */
+        void swap(out_message& other) noexcept;
+
+        /**
+         * \brief Preallocates buffer, so serialization of messages up to \p size bytes long (header included) doesn't allocate memory.
+         *
+         * \param size required buffer size
+         */
+        void reserve(size_t size) { m_buffer.reserve(size); }
+
+        /**
+         * \brief Releases unused buffer memory (e.g. before message is kept in pool after serialization of large message).
+         */
+        void shrink() { m_buffer.shrink_to_fit(); }
         
         /**
          * \brief Returns underlying data buffer.
          */
-        const std::vector<char>& get_data() const noexcept { return m_buffer; }
+        const message_buffer& get_data() const noexcept { return m_buffer; }
+
+        /**
+         * \brief Returns serialized data without header.
+         */
+        std::string_view get_payload() const noexcept { return std::string_view(m_buffer.data() + header_size, m_buffer.size() - header_size); }
+
+#if __MSG_USE_TRACING__
+        /**
+         * \brief Stores trace context to message header.
+         *
+         * \param context trace context
+         */
+        void set_trace_context(const trace_context& context) noexcept;
+
+        /**
+         * \brief Returns trace context from message header.
+         */
+        trace_context get_trace_context() const noexcept;
+#endif // __MSG_USE_TRACING__
         
     protected:
         /**
@@ -711,7 +1066,7 @@ namespace ipc
         template <type_tag Tag, typename T, typename = std::enable_if_t<trivial_type<T>::value>>
         out_message& push(T arg);
         
-        std::vector<char> m_buffer; ///< internal message buffer
+        message_buffer m_buffer; ///< internal message buffer
     };
 
     /**
@@ -741,6 +1096,15 @@ namespace ipc
          * \return message self reference 
          */
         in_message& operator >> (std::string& arg);
+
+        /**
+         * \brief Deserializes string data without copying.
+         * 
+         * \param arg - extracted string, it refers to message buffer and is valid until message is cleared or received again.
+         *
+         * \return message self reference 
+         */
+        in_message& operator >> (std::string_view& arg);
         
         /**
          * \brief Deserializes remote pointer from internal buffer.
@@ -770,23 +1134,212 @@ namespace ipc
          */
         template <size_t N>
         in_message& operator >> (std::pair<std::array<uint8_t, N>, size_t>& blob);
+
+        /**
+         * \brief Checks if fields of given types can be validated by #validate.
+         *
+         * \tparam Args fields types
+         */
+        template <typename... Args>
+        static constexpr bool can_validate = (field_traits<Args>::known && ...);
+
+        /**
+         * \brief Validates the rest of message against expected fields types by one pass.
+         *
+         * Tags (if __MSG_USE_TAGS__ is used) and lengths of all fields are checked in one loop, exceptions are the same as deserialization ones. 
+         * After successful validation fields may be extracted by #get_unchecked without per field checks.
+         *
+         * \tparam Args expected fields types (see #can_validate)
+         * \param exact if true message must end with the last field (ipc::type_mismach_exception is thrown otherwise), by default data after the last field 
+         * is ignored like field by field extraction does (e.g. optional fields appended by newer peers)
+         *
+         * \return message self reference 
+         */
+        template <typename... Args>
+        in_message& validate(bool exact = false);
+
+        /**
+         * \brief Extracts data of trivial type without checks, message must be validated by #validate first.
+         *
+         * \param arg - extracted data.
+         *
+         * \return message self reference 
+         */
+        template <typename T, typename = std::enable_if_t<trivial_type<T>::value>>
+        in_message& get_unchecked(T& arg) noexcept;
+
+        /**
+         * \brief Extracts remote pointer without checks, message must be validated by #validate first.
+         *
+         * \param p - extracted pointer.
+         *
+         * \return message self reference 
+         */
+        template <bool ConstPtr>
+        in_message& get_unchecked(remote_ptr<ConstPtr>& p) noexcept { return get_unchecked(get_u64_ptr(p)); }
+
+        /**
+         * \brief Extracts string without copying and checks, message must be validated by #validate first.
+         *
+         * \param arg - extracted string, it refers to message buffer.
+         *
+         * \return message self reference 
+         */
+        in_message& get_unchecked(std::string_view& arg) noexcept { arg = get_unchecked_data(true); return *this; }
+
+        /**
+         * \brief Extracts string without checks, message must be validated by #validate first.
+         *
+         * \param arg - extracted string.
+         *
+         * \return message self reference 
+         */
+        in_message& get_unchecked(std::string& arg);
+
+        /**
+         * \brief Extracts blob without checks, message must be validated by #validate first.
+         *
+         * \param blob - extracted data.
+         *
+         * \return message self reference 
+         */
+        in_message& get_unchecked(std::vector<uint8_t>& blob);
+
+        /**
+         * \brief Extracts blob without checks, message must be validated by #validate first.
+         *
+         * \param blob - extracted data, blob length has been checked against array size by #validate.
+         *
+         * \return message self reference 
+         */
+        template <size_t N>
+        in_message& get_unchecked(std::pair<std::array<uint8_t, N>, size_t>& blob) noexcept;
         
         /**
          * \brief Resets message to empty state.
          */
         void clear() noexcept;
+
+        /**
+         * \brief Copies raw message to buffer (it is enlarged to message length) and resets reading state.
+         *
+         * \param frame raw message (size header included)
+         */
+        void assign_frame(const char* frame);
         
         /**
          * \brief Default constructor
          *
-         * Allocates buffer of max available size and clears object state.
+         * Allocates buffer of max available size and clears object state, so raw message can be copied to #get_data directly.
+         *
+         * \deprecated Direct copying to preallocated buffer is kept for compatibility only. Use #assign_frame to fill message 
+         * and in_message(size_t) constructor to avoid preallocation (library uses it internally).
          */
-        in_message() : m_buffer(get_max_size()) { clear(); }
+        in_message() : in_message(msg_max_length) {}
+
+        /**
+         * \brief Creates message with small receive buffer.
+         *
+         * Buffer grows to the length of received (or assigned by #assign_frame) messages, so it must not be filled by direct copying to #get_data.
+         *
+         * \param initial_size initial buffer size (e.g. ipc::message::initial_read_size)
+         */
+        explicit in_message(size_t initial_size) { m_buffer.resize(std::max(initial_size, sizeof(__MSG_LENGTH_TYPE__))); clear(); }
+
+        /**
+         * \brief Move constructor.
+         *
+         * Received data (and its storage) is taken from \p other with current reading offset, \p other is cleared.
+         * Storage allocated from ipc::request_arena must not outlive arena scope.
+         *
+         * \param other source message
+         */
+        in_message(in_message&& other) noexcept;
+
+        /**
+         * \brief Move assignment.
+         *
+         * Received data (and its storage) is taken from \p other with current reading offset, \p other is cleared.
+         *
+         * \param other source message
+         *
+         * \return message self reference 
+         */
+        in_message& operator = (in_message&& other) noexcept;
+
+        /**
+         * \brief Exchanges received data and reading offsets of messages (no memory is allocated).
+         *
+         * \param other message to exchange data with
+         */
+        void swap(in_message& other) noexcept;
+
+        /**
+         * \brief Preallocates buffer, so receiving of messages up to \p size bytes long doesn't allocate memory.
+         *
+         * \param size required buffer size
+         */
+        void reserve(size_t size) { m_buffer.reserve(size); }
+
+        /**
+         * \brief Releases unused buffer memory (e.g. before message is kept in pool after receiving of large message).
+         */
+        void shrink() { m_buffer.shrink_to_fit(); }
         
         /**
          * \brief Returns underlying data buffer.
          */
-        std::vector<char>& get_data() noexcept { return m_buffer; }
+        message_buffer& get_data() noexcept { return m_buffer; }
+
+        /**
+         * \brief Returns received data (size header included).
+         */
+        std::string_view get_frame() const noexcept { return std::string_view(m_buffer.data(), *(const __MSG_LENGTH_TYPE__*)m_buffer.data()); }
+
+        /**
+         * \brief Returns received data without header.
+         */
+        std::string_view get_payload() const noexcept { return get_frame().substr(header_size); }
+
+#if __MSG_USE_TAGS__
+        /**
+         * \brief Builds index of fields offsets by one pass over type tags (fields are not deserialized).
+         *
+         * Index gives random access to fields (see #seek) and to unparsed tails of message (see #get_fields), so router that needs one argument 
+         * doesn't deserialize the others. Index is valid until message is cleared or received again.
+         *
+         * \return number of fields
+         */
+        size_t build_index();
+
+        /**
+         * \brief Returns number of indexed fields (see #build_index).
+         */
+        size_t get_fields_count() const noexcept { return m_index.size(); }
+
+        /**
+         * \brief Moves reading position to indexed field, so the next deserialization extracts it.
+         *
+         * \param field field number (less than #get_fields_count)
+         *
+         * \return message self reference 
+         */
+        in_message& seek(size_t field);
+
+        /**
+         * \brief Returns serialized fields from indexed field to message end (e.g. to forward them by ipc::out_message::append_fields).
+         *
+         * \param first first field number (not greater than #get_fields_count)
+         */
+        std::string_view get_fields(size_t first) const noexcept { return first < m_index.size() ? get_frame().substr(m_index[first]) : std::string_view(); }
+#endif // __MSG_USE_TAGS__
+
+#if __MSG_USE_TRACING__
+        /**
+         * \brief Returns trace context from message header.
+         */
+        trace_context get_trace_context() const noexcept;
+#endif // __MSG_USE_TRACING__
 
     protected:
         /**
@@ -797,11 +1350,162 @@ namespace ipc
         template <type_tag Tag, typename T, typename = std::enable_if_t<trivial_type<T>::value>>
         in_message& pop(T& arg);
 
-        std::vector<char> m_buffer; ///< internal message buffer
+        /**
+         * \brief Validates the rest of message against fields signature (#validate implementation).
+         *
+         * \param signature expected fields
+         * \param count number of fields
+         * \param exact if true message must end with the last field
+         */
+        void validate(const field_signature* signature, size_t count, bool exact);
+
+        /**
+         * \brief Extracts string or blob data without checks.
+         *
+         * \param string true for string, false for blob
+         */
+        std::string_view get_unchecked_data(bool string) noexcept;
+
+#if __MSG_USE_TAGS__
+        /**
+         * \brief Returns size of serialized field (type tag included) and checks that it fits message.
+         *
+         * \param offset field offset
+         * \param size message length
+         */
+        size_t get_field_size(size_t offset, size_t size);
+#endif // __MSG_USE_TAGS__
+
+        message_buffer m_buffer; ///< internal message buffer
         size_t m_offset; ///< current reading offset in #m_buffer
+        std::vector<__MSG_LENGTH_TYPE__> m_index; ///< offsets of fields (see #build_index)
+    };
+
+    /**
+     * \brief Output message that is built of fixed size segments.
+     *
+     * Message has the same format and serialization interface as ipc::out_message, but data is appended to chain of __MSG_SEGMENT_SIZE__ bytes segments 
+     * instead of one contiguous buffer, so building of large message never reallocates and copies serialized data. Segments are kept by #clear for the next message 
+     * and are written by PointToPointSocket::write_message with single vectored call. Segments are allocated from memory resource of creating thread (see ipc::get_message_resource).
+     */
+    class segmented_out_message : public message
+    {
+    public:
+        static constexpr size_t segment_size = __MSG_SEGMENT_SIZE__; ///< size of segment
+        static_assert(segment_size >= header_size, "__MSG_SEGMENT_SIZE__ is too small for message header");
+
+        /**
+         * \brief Serializes user's data of trivial type.
+         * 
+         * \param arg - data to serialize.
+         *
+         * \return message self reference 
+         */
+        template <typename T, typename = std::enable_if_t<trivial_type<T>::value>>
+        segmented_out_message& operator << (T arg) { return push<tag_traits<T>::value>(arg); }
+
+        /**
+         * \brief Serializes user's data of string type (std::string, const char*, std::string_view).
+         * 
+         * \param s - string to serialize.
+         *
+         * \return message self reference 
+         */
+        segmented_out_message& operator << (const std::string_view& s);
+
+        /**
+         * \brief Serializes user's pointer.
+         * 
+         * \param p - pointer to serialize.
+         *
+         * \return message self reference 
+         */
+        template <bool ConstPtr>
+        segmented_out_message& operator << (const remote_ptr<ConstPtr>& p) { return push<ConstPtr ? type_tag::const_remote_ptr : type_tag::remote_ptr>(get_u64_ptr(p)); }
+
+        /**
+         * \brief Serializes user's blob.
+         * 
+         * \param blob - blob to serialize.
+         *
+         * \return message self reference 
+         */
+        segmented_out_message& operator << (const std::pair<const uint8_t*, size_t>& blob);
+
+        /**
+         * \brief Resets message to empty state (segments are kept for reuse).
+         */
+        void clear() noexcept;
+
+        /**
+         * \brief Default constructor
+         *
+         * Allocates the first segment and clears object state.
+         */
+        segmented_out_message();
+        ~segmented_out_message(); ///< releases segments
+
+        size_t size() const noexcept { return m_size; } ///< returns message length (header included)
+        size_t get_segments_count() const noexcept { return (m_size + segment_size - 1) / segment_size; } ///< returns number of used segments
+
+        /**
+         * \brief Returns used part of segment.
+         *
+         * \param index segment index (less than #get_segments_count)
+         */
+        std::string_view get_segment(size_t index) const noexcept { return std::string_view(m_segments[index], m_size - index * segment_size < segment_size ? m_size - index * segment_size : segment_size); }
+
+        /**
+         * \brief Copies message to contiguous buffer (e.g. to store it or to pass it to API that expects ipc::out_message layout).
+         *
+         * \param buffer destination buffer
+         */
+        void flatten(message_buffer& buffer) const;
+
+    protected:
+        /**
+          * \brief Serializes user's data of trivial type with custom tag.
+          *
+          * \param arg - data to serialize.
+          */
+        template <type_tag Tag, typename T, typename = std::enable_if_t<trivial_type<T>::value>>
+        segmented_out_message& push(T arg);
+
+        /**
+         * \brief Checks that field fits message (throws ipc::message_overflow_exception otherwise) and updates length in header.
+         *
+         * \param func_name calling function name
+         * \param field_size serialized field size
+         */
+        void begin_field(const char* func_name, size_t field_size);
+
+        /**
+         * \brief Appends raw data, new segments are added on demand.
+         *
+         * \param data data to append
+         * \param size data size
+         */
+        void append(const char* data, size_t size);
+
+        std::pmr::memory_resource* m_resource; ///< memory resource of segments
+        std::vector<char*> m_segments; ///< allocated segments (the used ones and the ones kept for reuse)
+        size_t m_size; ///< used length
     };
 
     class server_socket;
+#ifndef _WIN32
+    class capture_log;
+#endif // _WIN32
+
+#if defined(__AFUNIX_H__) && !defined(_WIN32)
+    /**
+     * \brief Listening socket handle received from another process (see ipc::take_over_listener).
+     */
+    struct inherited_socket
+    {
+        socket_t handle; ///< listening socket handle
+    };
+#endif // __AFUNIX_H__ && !_WIN32
 
     /**
      * \brief Bidirectional data channel.
@@ -818,6 +1522,9 @@ namespace ipc
          * \p predicate may be called several times to ask if the function should continue waiting for data. If \p predicate returns false function 
          * will immediately return false and state of message will be invalid and must be reset.
          *
+         * Buffer is enlarged to the message length (read from its length prefix), so it doesn't need to be preallocated for the longest message.
+         * Length prefix that is shorter than prefix itself causes ipc::bad_message_exception, length greater than __MSG_MAX_LENGTH__ causes ipc::message_overflow_exception.
+         *
          * \param message raw message buffer (length and data, see ipc::Message)
          * \param predicate function of type bool() or similar callable object 
          *
@@ -874,6 +1581,20 @@ namespace ipc
         template<typename Predicate>
         bool write_message(out_message& message, const Predicate& predicate) { return write_message(message.get_data().data(), predicate); }
 
+        /**
+          * \brief Writes segmented message to channel by vectored writes (segments are not copied).
+          *          
+          * \p predicate may be called several times to ask if the function should continue trying to write data. If \p predicate returns false function 
+          * will immediately return false and message may be written partially.
+          *
+          * \param message object
+          * \param predicate function of type bool() or similar callable object 
+          *
+          * \return true if message has been written
+          */
+        template<typename Predicate>
+        bool write_message(const segmented_out_message& message, const Predicate& predicate);
+
         /**
           * \brief Waits for shutdown signal.
           *          
@@ -894,10 +1615,68 @@ namespace ipc
           */
         void shutdown() noexcept;
 
+#if defined(__AFUNIX_H__) && !defined(_WIN32)
+        /**
+          * \brief Sends socket handle to another process (UNIX sockets only).
+          *
+          * Handle is duplicated into receiving process (SCM_RIGHTS), so both processes share the same socket.
+          *
+          * \param handle socket handle to send (it is still owned by caller)
+          *
+          * \sa #receive_handle.
+          */
+        void send_handle(socket_t handle);
+
+        /**
+          * \brief Receives socket handle sent by #send_handle (UNIX sockets only).
+          *          
+          * \p predicate may be called several times to ask if the function should continue waiting for data. If \p predicate returns false function 
+          * will immediately throw ipc::user_stop_request_exception.
+          *
+          * \param predicate function of type bool() or similar callable object 
+          *
+          * \return received socket handle (caller owns it)
+          */
+        template<typename Predicate>
+        socket_t receive_handle(const Predicate& predicate);
+#endif // __AFUNIX_H__ && !_WIN32
+
+#ifndef _WIN32
+        /**
+          * \brief Enables capturing of all read and written messages to \p log (POSIX only).
+          *
+          * \param log capture log (nullptr disables capturing), it must outlive socket
+          * \param connection_id identifier of connection in \p log (see ipc::capture_log::make_connection_id)
+          */
+        void set_capture(capture_log* log, uint64_t connection_id) noexcept { m_capture = log; m_connection_id = connection_id; }
+#endif // _WIN32
+
         ~point_to_point_socket() { shutdown(); }
     protected:
         typedef socket super; ///< super class typedef
 
+#ifndef _WIN32
+        capture_log* m_capture = nullptr; ///< capture log (optional)
+        uint64_t m_connection_id = 0; ///< connection identifier in capture log
+
+        /**
+         * \brief Appends message to capture log.
+         *
+         * \param message raw message
+         * \param written true if message has been written, false if it has been read
+         */
+        void capture_message(const char* message, bool written) noexcept;
+#endif // _WIN32
+
+        /**
+         * \brief Reads raw message to buffer that is enlarged to message length (#read_message implementation).
+         *
+         * \param message raw message buffer (std::vector<char> or ipc::message_buffer)
+         * \param predicate function of type bool() or similar callable object
+         */
+        template <typename Buffer, typename Predicate>
+        bool read_frame(Buffer& message, const Predicate& predicate);
+
         /**
          * \brief Socket handle based constructor
          *
@@ -915,6 +1694,9 @@ namespace ipc
      */
     class client_socket : public point_to_point_socket
     {
+    public:
+        static constexpr int default_connect_attempts = 10; ///< default number of connection attempts (there is 1 second delay between attempts if server refuses connection)
+
     protected:
         /**
          * \brief Socket handle based constructor. Just forwards \p s to ipc::point_to_point_socket constructor.
@@ -928,8 +1710,9 @@ namespace ipc
          *
          * \param address filled sockaddr compatible structure
          * \param size size of structure pointed by address
+         * \param max_attempts max number of connection attempts
          */
-        void connect_proc(const sockaddr* address, size_t size);
+        void connect_proc(const sockaddr* address, size_t size, int max_attempts);
     };
 
     /**
@@ -943,20 +1726,22 @@ namespace ipc
           *
           * \param address server IP address
           * \param port TCP port number
+          * \param max_attempts max number of connection attempts
           */
-        tcp_client_socket(uint32_t address, uint16_t port);
+        tcp_client_socket(uint32_t address, uint16_t port, int max_attempts = default_connect_attempts);
 
         /**
          * \brief Tries to connect to TCP with \p port.
          *
          * \param address server IP address (null termination is required)
          * \param port TCP port number
+         * \param max_attempts max number of connection attempts
          */
 
-        tcp_client_socket(std::string_view address, uint16_t port);
+        tcp_client_socket(std::string_view address, uint16_t port, int max_attempts = default_connect_attempts);
 
     private:
-        void connect_proc(uint32_t address, uint16_t port);
+        void connect_proc(uint32_t address, uint16_t port, int max_attempts);
 
         typedef client_socket super; ///< super class typedef
     };
@@ -974,8 +1759,9 @@ namespace ipc
           * \brief Tries to connect to UNIX socket \p path.
           *      
           * \param path UNIX socket path (must be null terminated)
+          * \param max_attempts max number of connection attempts
           */
-        explicit unix_client_socket(std::string_view path);
+        explicit unix_client_socket(std::string_view path, int max_attempts = default_connect_attempts);
 
     private:
         typedef client_socket super; ///< super class typedef
@@ -999,6 +1785,13 @@ namespace ipc
          */
         template<typename Predicate>
         point_to_point_socket accept(const Predicate& predicate);
+
+        /**
+         * \brief Marks socket as handed off to another process (see ipc::point_to_point_socket::send_handle).
+         *
+         * Resources shared with another process (UNIX socket file) will not be removed on close.
+         */
+        void hand_off() noexcept {}
     protected:
         /**
         * \brief Default constructor
@@ -1008,6 +1801,15 @@ namespace ipc
     
         server_socket() noexcept : socket(INVALID_SOCKET) {}
 
+        /**
+        * \brief Socket handle based constructor
+        *
+        * Acquired listening socket handle will be closed automatically on instance destruction (RAII)
+        *
+        * \param s listening socket handle
+        */
+        explicit server_socket(socket_t s) : socket(s) {}
+
         std::mutex m_lock; ///< mutex for accept requests synchronizing
 
         /**
@@ -1034,9 +1836,20 @@ namespace ipc
          * \param path UNIX socket path
          */
         explicit unix_server_socket(std::string_view path);
+
+#ifndef _WIN32
+        /**
+         * \brief Creates instance from listening socket of another process (see ipc::take_over_listener).
+         *
+         * \param path UNIX socket path (socket file will be removed on close)
+         * \param s inherited listening socket
+         */
+        unix_server_socket(std::string_view path, inherited_socket s) : server_socket(s.handle), m_link(path) {}
+#endif // _WIN32
         
         ~unix_server_socket() { close(); };
         void close() noexcept; ///< closes socket
+        void hand_off() noexcept { m_link.clear(); } ///< marks socket as handed off to another process (socket file will not be removed on close)
     protected:
         typedef server_socket super; ///< super class typedef
         std::string m_link; ///< server text identifier
@@ -1055,7 +1868,33 @@ namespace ipc
          * \param port TCP port number
          */
         explicit tcp_server_socket(uint16_t port);
+
+#if defined(__AFUNIX_H__) && !defined(_WIN32)
+        /**
+         * \brief Creates instance from listening socket of another process (see ipc::take_over_listener).
+         *
+         * \param s inherited listening socket
+         */
+        explicit tcp_server_socket(inherited_socket s) : server_socket(s.handle) {}
+#endif // __AFUNIX_H__ && !_WIN32
     };
+
+#if defined(__AFUNIX_H__) && !defined(_WIN32)
+    /**
+     * \brief Receives listening socket from running server (see ipc::rpc_server::enable_handoff).
+     *
+     * Connects to handoff control socket \p control_path of running server and receives its listening socket handle. After that running server stops accepting 
+     * new connections, finishes processing of accepted ones and exits, so no connection is refused during restart.
+     *
+     * \param control_path handoff control UNIX socket path
+     * \param predicate function of type bool() or similar callable object 
+     * \param max_attempts number of connection attempts
+     *
+     * \return inherited socket that can be passed to ipc::tcp_server_socket or ipc::unix_server_socket constructor
+     */
+    template<typename Predicate>
+    inherited_socket take_over_listener(std::string_view control_path, const Predicate& predicate, int max_attempts = 1);
+#endif // __AFUNIX_H__ && !_WIN32
 }
 
 #ifndef __DOXYGEN__
@@ -0,0 +1,173 @@
+/**
+ * \file metrics.hpp
+ *
+ * \brief Additional IPC library components (server metrics).
+ *
+ * \copyright Copyright (C) 2020 Pavel Kovalenko. All rights reserved.<br>
+ * <br>
+ * This Source Code Form is subject to the terms of the Mozilla<br>
+ * Public License, v. 2.0. If a copy of the MPL was not distributed<br>
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#ifndef __DOXYGEN__
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#endif // __DOXYGEN__
+
+#include "ipc.hpp"
+
+namespace ipc
+{
+    /**
+     * \brief Latency summary of remote function.
+     *
+     * Percentiles are estimated by power of two histogram, so they are upper bounds (true value is not less than half of estimation).
+     */
+    struct function_metrics
+    {
+        uint32_t function = 0; ///< remote function identifier
+        uint64_t calls = 0; ///< number of processed calls
+        uint64_t total = 0; ///< total processing time (nanoseconds)
+        uint64_t max = 0; ///< max processing time (nanoseconds)
+        uint64_t p50 = 0; ///< median processing time estimation (nanoseconds)
+        uint64_t p99 = 0; ///< 99th percentile of processing time estimation (nanoseconds)
+    };
+
+    /**
+     * \brief Server counters at some moment.
+     */
+    struct metrics_snapshot
+    {
+        uint64_t uptime = 0; ///< time since metrics enabling (nanoseconds)
+        uint64_t workers = 0; ///< number of worker threads
+        uint64_t active_connections = 0; ///< number of connections that are being processed (workers that are not waiting for connection)
+        uint64_t busy_time = 0; ///< total time of connections processing by all workers (nanoseconds), busy_time / (workers * uptime) is workers utilization
+        uint64_t connections = 0; ///< number of accepted connections
+        uint64_t errors = 0; ///< number of failed connections
+        uint64_t untracked_calls = 0; ///< number of processed calls of functions that don't fit functions table
+        uint64_t cache_memory = 0; ///< memory used by responses cache (see ipc::rpc_server::enable_response_cache)
+        std::vector<function_metrics> functions; ///< latency summaries of called functions
+
+        /**
+         * \brief Serializes snapshot to message.
+         *
+         * \param msg output message
+         */
+        void serialize(out_message& msg) const;
+
+        /**
+         * \brief Deserializes snapshot from message.
+         *
+         * \param msg input message
+         */
+        void deserialize(in_message& msg);
+    };
+
+    /**
+     * \brief Lock free counters of ipc::rpc_server (see ipc::rpc_server::enable_metrics).
+     *
+     * Latency of up to #max_functions different functions is tracked, calls of other functions are only counted.
+     */
+    class server_metrics
+    {
+    public:
+        typedef std::chrono::steady_clock clock; ///< clock used for calls timing
+
+        static constexpr size_t max_functions = 128; ///< size of functions table
+        static constexpr size_t histogram_size = 40; ///< number of latency histogram buckets (powers of two nanoseconds)
+
+        server_metrics() noexcept : m_start(clock::now()) {}
+
+        server_metrics(const server_metrics&) = delete;
+        server_metrics& operator = (const server_metrics&) = delete;
+
+        /**
+         * \brief Counts connection while instance exists.
+         */
+        class connection_scope
+        {
+        public:
+            /**
+             * \brief Counts accepted connection.
+             *
+             * \param metrics server metrics (nullptr means metrics are disabled)
+             */
+            explicit connection_scope(server_metrics* metrics) noexcept;
+            ~connection_scope(); ///< counts connection processing time
+
+            connection_scope(const connection_scope&) = delete;
+            connection_scope& operator = (const connection_scope&) = delete;
+
+        protected:
+            server_metrics* m_metrics; ///< server metrics
+            clock::time_point m_start; ///< connection accepting time
+        };
+
+        /**
+         * \brief Adds (or removes) worker threads.
+         *
+         * \param count number of workers
+         */
+        void add_workers(int64_t count) noexcept { m_workers.fetch_add(count, std::memory_order_relaxed); }
+
+        /**
+         * \brief Counts processed call.
+         *
+         * \param function remote function identifier
+         * \param latency call processing time
+         */
+        void record_call(uint32_t function, clock::duration latency) noexcept;
+
+        /**
+         * \brief Counts failed connection.
+         */
+        void record_error() noexcept { m_errors.fetch_add(1, std::memory_order_relaxed); }
+
+        /**
+         * \brief Returns current counters.
+         *
+         * \param cache_memory memory used by responses cache
+         */
+        metrics_snapshot get_snapshot(uint64_t cache_memory = 0) const;
+
+    protected:
+        /**
+         * \brief Functions table entry.
+         */
+        struct function_slot
+        {
+            std::atomic<uint64_t> key = 0; ///< function identifier + 1 (zero means free entry)
+            std::atomic<uint64_t> calls = 0; ///< number of calls
+            std::atomic<uint64_t> total = 0; ///< total processing time
+            std::atomic<uint64_t> max = 0; ///< max processing time
+            std::array<std::atomic<uint64_t>, histogram_size> histogram = {}; ///< number of calls by power of two of processing time
+        };
+
+        /**
+         * \brief Finds (or occupies) entry of function.
+         *
+         * \param function remote function identifier
+         *
+         * \return nullptr if table is full
+         */
+        function_slot* find_slot(uint32_t function) noexcept;
+
+        clock::time_point m_start; ///< metrics enabling time
+        std::atomic<int64_t> m_workers = 0; ///< number of worker threads
+        std::atomic<int64_t> m_active = 0; ///< number of active connections
+        std::atomic<uint64_t> m_busy_time = 0; ///< total connections processing time
+        std::atomic<uint64_t> m_connections = 0; ///< number of accepted connections
+        std::atomic<uint64_t> m_errors = 0; ///< number of failed connections
+        std::atomic<uint64_t> m_untracked = 0; ///< number of calls of functions that don't fit the table
+        std::array<function_slot, max_functions> m_functions; ///< functions table (open addressing)
+    };
+}
+
+#ifndef __DOXYGEN__
+#include "../source/metrics_impl.hpp"
+#endif // __DOXYGEN__
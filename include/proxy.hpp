@@ -0,0 +1,140 @@
+/**
+ * \file proxy.hpp
+ *
+ * \brief Additional IPC library components (routing proxy).
+ *
+ * \copyright Copyright (C) 2020 Pavel Kovalenko. All rights reserved.<br>
+ * <br>
+ * This Source Code Form is subject to the terms of the Mozilla<br>
+ * Public License, v. 2.0. If a copy of the MPL was not distributed<br>
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#ifndef __DOXYGEN__
+#include <chrono>
+#include <thread>
+#include <vector>
+#endif // __DOXYGEN__
+
+#include "balancer.hpp"
+#include "ipc.hpp"
+
+namespace ipc
+{
+    /**
+     * \brief Byte stream forwarder between sockets.
+     *
+     * Data is moved by splice through kernel pipe on Linux (it is never copied to user space), other platforms use user space buffer.
+     */
+    class socket_relay
+    {
+    public:
+        static constexpr size_t chunk_size = 65536; ///< max size of data forwarded by single step
+
+        socket_relay(); ///< creates pipe (or buffer)
+        ~socket_relay(); ///< closes pipe
+
+        socket_relay(const socket_relay&) = delete;
+        socket_relay& operator = (const socket_relay&) = delete;
+
+        /**
+         * \brief Forwards available data from \p from to \p to.
+         *
+         * \param from readable source socket
+         * \param to destination socket
+         * \param predicate function of type bool() or similar callable object, it is called while destination is not writable
+         *
+         * \return false if source has been closed
+         */
+        template <typename Predicate>
+        bool forward(socket_t from, socket_t to, const Predicate& predicate);
+
+    protected:
+        void discard() noexcept; ///< drops data that has been read but not written (pipe is reused by the next connection)
+
+#ifdef __linux__
+        int m_pipe[2]; ///< kernel pipe (read and write ends)
+#else
+        std::vector<char> m_buffer; ///< user space buffer
+#endif // __linux__
+    };
+
+    /**
+     * \brief Routing proxy of remote procedure calls.
+     *
+     * Proxy accepts connections, reads the first request frame and deserializes function identifier only (the first field), selects backend by router and forwards the request frame as is. 
+     * After that all traffic of connection (responses, callbacks and their results) is relayed in both directions without deserialization until both sides close connection.
+     * So callbacks and remote reads work through proxy, and proxy doesn't depend on functions signatures.
+     *
+     * \note Backend connection failures (and transport failures of backend side of relayed connections) are reported to endpoint circuit breakers of router's balancer.
+     * Failures of client side and idle timeouts release backend without result, so bad or slow clients don't eject healthy backends.
+     * On POSIX proxy process should ignore SIGPIPE, because peers may close connections while data is forwarded.
+     *
+     * \tparam Server_socket server socket class that will be used by proxy
+     */
+    template <typename Server_socket>
+    class rpc_proxy
+    {
+    public:
+        typedef std::chrono::steady_clock clock; ///< clock used for idle timeout
+
+        /**
+         * \brief Creates proxy.
+         *
+         * \param args info for socket creation
+         */
+        template <typename... Args>
+        explicit rpc_proxy(const Args&... args) : m_server_socket(args...) {}
+
+        /**
+         * \brief Sets max time of relayed connection inactivity (connection is closed after it).
+         *
+         * \param timeout idle timeout
+         */
+        void set_idle_timeout(clock::duration timeout) noexcept { m_idle_timeout = timeout; }
+
+        /**
+         * \brief Enables calls forwarding.
+         *
+         * This routine creates and runs \p threads_count workers, each of them accepts and forwards incoming connections. After successful running of workers Router::ready callback will be called.
+         *
+         * \param router object that must have several methods: ipc::load_balancer<Tuple>& route(uint32_t) const (returns backends of function), 
+         * void report_error(const std::exception_ptr&) const and void ready() const.
+         * \param predicate predicate function (or function-like object) that allows user to stop worker threads.
+         * \param threads_count number of workers (each of them forwards one connection at once)
+         */
+        template <typename Router, typename Predicate>
+        void run(const Router& router, const Predicate& predicate, unsigned int threads_count = std::thread::hardware_concurrency());
+
+    protected:
+        Server_socket m_server_socket; ///< passive socket channel instance
+        clock::duration m_idle_timeout = std::chrono::seconds(60); ///< max time of connection inactivity
+
+        /**
+         * \brief Worker routine.
+         *
+         * \param router backends router
+         * \param predicate predicate function (or function-like object) that allows user to stop worker
+         */
+        template <typename Router, typename Predicate>
+        void thread_proc(const Router* router, const Predicate* predicate);
+
+        /**
+         * \brief Relays traffic in both directions until both sides close connection.
+         *
+         * \param client client connection
+         * \param backend backend connection
+         * \param relay forwarder of worker
+         * \param predicate predicate function (or function-like object) that allows user to stop worker
+         * \param backend_failed set to true if exception is caused by backend socket failure
+         */
+        template <typename Predicate>
+        void relay_connection(point_to_point_socket& client, point_to_point_socket& backend, socket_relay& relay, const Predicate& predicate, bool& backend_failed);
+    };
+}
+
+#ifndef __DOXYGEN__
+#include "../source/proxy_impl.hpp"
+#endif // __DOXYGEN__
@@ -0,0 +1,314 @@
+/**
+ * \file pubsub.hpp
+ *
+ * \brief Additional IPC library components (publish/subscribe service).
+ *
+ * \copyright Copyright (C) 2020 Pavel Kovalenko. All rights reserved.<br>
+ * <br>
+ * This Source Code Form is subject to the terms of the Mozilla<br>
+ * Public License, v. 2.0. If a copy of the MPL was not distributed<br>
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#ifndef __DOXYGEN__
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#endif // __DOXYGEN__
+
+#include "ipc.hpp"
+
+namespace ipc
+{
+    /**
+     * \brief Kinds of publish/subscribe protocol messages (the first field of every message).
+     */
+    enum class pubsub_message : uint32_t
+    {
+        subscribe = 0, ///< client subscribes to topic (followed by topic)
+        unsubscribe = 1, ///< client unsubscribes from topic (followed by topic)
+        publication = 2, ///< published message (followed by topic and published fields)
+        dropped = 3 ///< number of publications dropped because client is too slow (followed by uint64_t count)
+    };
+
+    /**
+     * \brief Reader of back to back messages of connection.
+     *
+     * Unlike ipc::point_to_point_socket::read_message (that expects single message in flight, as request/response exchange does) it reads data by large chunks 
+     * and splits them by messages length prefixes, so stream of messages is read by few system calls.
+     */
+    class message_stream
+    {
+    public:
+        static constexpr size_t default_chunk_size = 65536; ///< default size of read buffer
+
+        /**
+         * \brief Creates reader.
+         *
+         * \param chunk_size initial size of read buffer (it is enlarged for longer messages)
+         */
+        explicit message_stream(size_t chunk_size = default_chunk_size) : m_buffer(chunk_size > sizeof(__MSG_LENGTH_TYPE__) ? chunk_size : sizeof(__MSG_LENGTH_TYPE__)) {}
+
+        /**
+         * \brief Reads the next message of connection.
+         *
+         * \param socket connection
+         * \param message message object
+         * \param predicate function of type bool() or similar callable object
+         */
+        template <typename Predicate>
+        void read_message(point_to_point_socket& socket, in_message& message, const Predicate& predicate);
+
+        /**
+         * \brief Returns number of read bytes that haven't been returned as messages yet.
+         */
+        size_t get_buffered_size() const noexcept { return m_end - m_begin; }
+
+    protected:
+        std::vector<char> m_buffer; ///< read buffer
+        size_t m_begin = 0; ///< the first unreturned byte
+        size_t m_end = 0; ///< end of read data
+    };
+
+    /**
+     * \brief Publish/subscribe service.
+     *
+     * Clients (see ipc::pubsub_client) keep persistent connections and subscribe to topics by name. Every published message is serialized once
+     * and the same buffer is queued to all subscribers of its topic. Each subscriber has bounded queue: when slow subscriber doesn't keep up
+     * with publishers new publications are dropped for it (other subscribers are not affected), and subscriber is notified about number
+     * of dropped publications before the next delivered one.
+     *
+     * \note Subscription commands are checked between deliveries at least every #command_poll_interval, so subscription becomes active
+     * a bit later than command is sent (see #get_subscribers_count).
+     *
+     * \tparam Server_socket server socket class that will be used by service
+     */
+    template <typename Server_socket>
+    class pubsub_server
+    {
+    public:
+        typedef std::chrono::steady_clock clock; ///< clock used for waiting
+
+        static constexpr size_t default_queue_capacity = 1024; ///< default max number of publications queued to subscriber
+        static constexpr std::chrono::milliseconds command_poll_interval{ 20 }; ///< max delay of subscription commands processing
+
+        /**
+         * \brief Creates service.
+         *
+         * \param args info for socket creation
+         */
+        template <typename... Args>
+        explicit pubsub_server(const Args&... args) : m_server_socket(args...) {}
+
+        /**
+         * \brief Sets max number of publications queued to each subscriber (affects connections accepted later).
+         *
+         * \param capacity queue capacity
+         */
+        void set_queue_capacity(size_t capacity) noexcept { m_queue_capacity = capacity > 0 ? capacity : 1; }
+
+        /**
+         * \brief Publishes message to all subscribers of \p topic.
+         *
+         * Message is serialized once and shared by all subscribers queues. It can be called by any thread.
+         *
+         * \param topic topic name
+         * \param args published fields
+         *
+         * \return number of subscribers that have queued publication (subscribers with full queues drop it)
+         */
+        template <typename... Args>
+        size_t publish(std::string_view topic, const Args&... args);
+
+        /**
+         * \brief Returns number of subscribers of \p topic.
+         *
+         * \param topic topic name
+         */
+        size_t get_subscribers_count(std::string_view topic) const;
+
+        /**
+         * \brief Returns total number of publications dropped because of slow subscribers.
+         */
+        uint64_t get_dropped_count() const noexcept { return m_dropped.load(std::memory_order_relaxed); }
+
+        /**
+         * \brief Enables subscribers serving.
+         *
+         * This routine creates and runs \p max_subscribers workers, each of them accepts and serves one subscriber connection at once.
+         * After successful running of workers Handler::ready callback will be called.
+         *
+         * \param handler object that must have several methods: void report_error(const std::exception_ptr&) const and void ready() const.
+         * \param predicate predicate function (or function-like object) that allows user to stop worker threads.
+         * \param max_subscribers number of workers (max number of simultaneously connected subscribers)
+         */
+        template <typename Handler, typename Predicate>
+        void run(const Handler& handler, const Predicate& predicate, unsigned int max_subscribers = 64);
+
+    protected:
+        typedef std::shared_ptr<const out_message> publication_ptr; ///< serialized publication shared by subscribers queues
+
+        /**
+         * \brief Bounded publications queue of connected subscriber.
+         */
+        class subscriber
+        {
+        public:
+            /**
+             * \brief Creates empty queue.
+             *
+             * \param capacity max number of queued publications
+             */
+            explicit subscriber(size_t capacity) : m_capacity(capacity) { m_queue.reserve(capacity); }
+
+            /**
+             * \brief Queues publication.
+             *
+             * \param publication serialized publication
+             *
+             * \return false if queue is full (publication is dropped)
+             */
+            bool push(const publication_ptr& publication);
+
+            /**
+             * \brief Takes all queued publications, waits for them up to \p timeout if queue is empty.
+             *
+             * \param batch empty vector that receives publications
+             * \param timeout max waiting time
+             *
+             * \return number of publications dropped since previous call
+             */
+            uint64_t take(std::vector<publication_ptr>& batch, clock::duration timeout);
+
+        protected:
+            std::mutex m_lock; ///< queue lock
+            std::condition_variable m_wake; ///< queue filling notification
+            std::vector<publication_ptr> m_queue; ///< queued publications
+            size_t m_capacity; ///< max number of queued publications
+            uint64_t m_dropped = 0; ///< number of publications dropped since previous #take call
+        };
+
+        Server_socket m_server_socket; ///< passive socket channel instance
+        size_t m_queue_capacity = default_queue_capacity; ///< capacity of subscribers queues
+        mutable std::mutex m_lock; ///< topics map lock
+        std::map<std::string, std::vector<subscriber*>, std::less<>> m_topics; ///< subscribers of topics
+        std::atomic<uint64_t> m_dropped = 0; ///< total number of dropped publications
+
+        /**
+         * \brief Worker routine.
+         *
+         * \param handler errors handler
+         * \param predicate predicate function (or function-like object) that allows user to stop worker
+         */
+        template <typename Handler, typename Predicate>
+        void thread_proc(const Handler* handler, const Predicate* predicate);
+
+        /**
+         * \brief Delivers publications to connected subscriber and processes its commands until connection is closed.
+         *
+         * \param client subscriber connection
+         * \param s subscriber queue
+         * \param topics receives topics subscribed by connection
+         * \param predicate predicate function (or function-like object) that allows user to stop worker
+         */
+        template <typename Predicate>
+        void serve(point_to_point_socket& client, subscriber& s, std::vector<std::string>& topics, const Predicate& predicate);
+
+        /**
+         * \brief Adds subscriber to topic.
+         *
+         * \param s subscriber
+         * \param topic topic name
+         */
+        void subscribe(subscriber& s, std::string_view topic);
+
+        /**
+         * \brief Removes subscriber from topic.
+         *
+         * \param s subscriber
+         * \param topic topic name
+         */
+        void unsubscribe(subscriber& s, std::string_view topic);
+    };
+
+    /**
+     * \brief Client of publish/subscribe service (see ipc::pubsub_server).
+     *
+     * \tparam Client_socket client socket class that will be used for connection
+     */
+    template <typename Client_socket>
+    class pubsub_client
+    {
+    public:
+        /**
+         * \brief Connects to service.
+         *
+         * \param args info for socket creation
+         */
+        template <typename... Args>
+        explicit pubsub_client(const Args&... args) : m_socket(args...) {}
+
+        /**
+         * \brief Subscribes to topic (publications are delivered after server processes command).
+         *
+         * \param topic topic name
+         * \param predicate function of type bool() or similar callable object
+         */
+        template <typename Predicate>
+        void subscribe(std::string_view topic, const Predicate& predicate) { send_command(pubsub_message::subscribe, topic, predicate); }
+
+        /**
+         * \brief Unsubscribes from topic (publications queued before server processes command are still delivered).
+         *
+         * \param topic topic name
+         * \param predicate function of type bool() or similar callable object
+         */
+        template <typename Predicate>
+        void unsubscribe(std::string_view topic, const Predicate& predicate) { send_command(pubsub_message::unsubscribe, topic, predicate); }
+
+        /**
+         * \brief Waits for the next publication.
+         *
+         * \param message message that receives publication, it is positioned at the first published field
+         * \param predicate function of type bool() or similar callable object
+         *
+         * \return publication topic (it points to \p message data)
+         */
+        template <typename Predicate>
+        std::string_view receive(in_message& message, const Predicate& predicate);
+
+        /**
+         * \brief Returns number of publications dropped by server because client hasn't received them in time.
+         */
+        uint64_t get_dropped_count() const noexcept { return m_dropped; }
+
+    protected:
+        Client_socket m_socket; ///< connection to service
+        out_message m_command; ///< command message
+        message_stream m_stream; ///< publications reader
+        uint64_t m_dropped = 0; ///< number of dropped publications
+
+        /**
+         * \brief Sends subscription command.
+         *
+         * \param command command kind
+         * \param topic topic name
+         * \param predicate function of type bool() or similar callable object
+         */
+        template <typename Predicate>
+        void send_command(pubsub_message command, std::string_view topic, const Predicate& predicate);
+    };
+}
+
+#ifndef __DOXYGEN__
+#include "../source/pubsub_impl.hpp"
+#endif // __DOXYGEN__
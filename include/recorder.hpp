@@ -0,0 +1,73 @@
+/**
+ * \file recorder.hpp
+ *
+ * \brief Additional IPC library components (flight recorder).
+ *
+ * \copyright Copyright (C) 2020 Pavel Kovalenko. All rights reserved.<br>
+ * <br>
+ * This Source Code Form is subject to the terms of the Mozilla<br>
+ * Public License, v. 2.0. If a copy of the MPL was not distributed<br>
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#ifndef __DOXYGEN__
+#include <cstdint>
+#endif // __DOXYGEN__
+
+namespace ipc
+{
+    /**
+     * \brief Flight recorder event types.
+     */
+    enum class flight_event : uint8_t
+    {
+        accept, ///< connection has been accepted by ipc::rpc_server
+        read_start, ///< request reading has been started
+        read_end, ///< request has been read
+        dispatch_start, ///< request dispatching has been started (value is function identifier)
+        dispatch_end, ///< request has been dispatched (value is function identifier)
+        write, ///< response has been written
+        error, ///< request processing or remote call has failed
+        call_start, ///< remote call has been started by ipc::service_invoker (value is function identifier)
+        call_end ///< remote call has been finished (value is function identifier)
+    };
+
+    /**
+     * \brief Records event to flight recorder of current thread.
+     *
+     * Each thread has its own fixed size ring buffer of recent events, event recording costs a few nanoseconds (CPU timestamp counter is used where it is available),
+     * so flight recorder is always on. ipc::rpc_server and ipc::service_invoker record their events automatically.
+     *
+     * \param e event type
+     * \param value event argument
+     */
+    void record_flight_event(flight_event e, uint32_t value = 0) noexcept;
+
+    /**
+     * \brief Writes recent events of all threads to file descriptor (one event per text line, grouped by threads, the oldest events first).
+     *
+     * Event time is printed as nanoseconds before dump. Function is async signal safe (it doesn't allocate memory or take locks), so it can be called
+     * by signal handler or Dispatcher::report_error. Events that are being recorded during dumping may be printed inconsistently.
+     *
+     * \param fd file descriptor
+     */
+    void dump_flight_recorder(int fd) noexcept;
+
+#ifndef _WIN32
+    /**
+     * \brief Installs handler of signal \p signum that dumps flight recorder to \p fd (POSIX only).
+     *
+     * \param signum signal number
+     * \param fd file descriptor (standard error by default)
+     *
+     * \return false if handler can't be installed
+     */
+    bool install_flight_recorder_handler(int signum, int fd = 2) noexcept;
+#endif // _WIN32
+}
+
+#ifndef __DOXYGEN__
+#include "../source/recorder_impl.hpp"
+#endif // __DOXYGEN__
@@ -13,10 +13,21 @@
 #pragma once
 
 #ifndef __DOXYGEN__
+#include  <atomic>
 #include  <thread>
+#ifndef _WIN32
+#   include <signal.h>
+#endif // _WIN32
 #endif // __DOXYGEN__
 
+#include "balancer.hpp"
+#include "cache.hpp"
+#include "capture.hpp"
 #include "ipc.hpp"
+#include "metrics.hpp"
+#include "recorder.hpp"
+#include "slowlog.hpp"
+#include "trace.hpp"
 
 namespace ipc
 {
@@ -27,6 +38,9 @@ namespace ipc
     {
     public:
         static const uint32_t done_tag = 0xFFFFFFFFu; ///< final result marker, greatest uint32_t value
+        static const uint32_t remote_read_tag = 0xFFFFFFFEu; ///< batched remote memory read request marker, it is processed by ipc::service_invoker::call_by_address without dispatcher call
+        static const uint32_t metrics_id = 0xFFFFFFFDu; ///< reserved function identifier of server metrics request, it is processed by ipc::rpc_server without dispatcher call (see ipc::rpc_server::enable_metrics)
+        static const uint32_t max_remote_read_size = 32768; ///< max total size of values read by single ipc::service_invoker::read_by_channel request
     protected:
         function_invoker_base() = default;
     };
@@ -46,6 +60,7 @@ namespace ipc
      * \brief Lightweight native function call helper.
      * 
      * This class takes care about native function arguments deserializing, function (or function-like object) call and result serializing. Native function arguments types must have serializable types.
+     * Arguments of library types are validated by one pass (see ipc::in_message::validate), so request must end with the last argument, and then extracted without per field checks.
      *
      * \tparam Use_done_tag set it to true if you want to set ipc::function_invoker_base::done_tag in the begin of result message (it can be used to interrupt client callback processing loop)
      * \tparam R return value type, const reference modifiers will be removed
@@ -66,12 +81,90 @@ namespace ipc
         void operator()(in_message& in_msg, out_message& out_msg, Func&& func);
     };
 
+    /**
+     * \brief Helper structure that marks remote function as cacheable on client side.
+     *
+     * Specialize it with true value for functions which results may be memoized by ipc::service_invoker (see ipc::service_invoker::service_invoker(call_cache&)).
+     * Such functions must not have remote pointer arguments and should not use callbacks.
+     *
+     * \tparam Id identifier of remote function
+     */
+    template <uint32_t Id>
+    struct cacheable_call
+    {
+        static const bool value = false; ///< check result
+    };
+
+    /**
+     * \brief Helper structure that marks remote function as idempotent on client side.
+     *
+     * Idempotent functions calls may be hedged (see ipc::service_invoker::call_hedged). Cacheable functions are idempotent by default.
+     *
+     * \tparam Id identifier of remote function
+     */
+    template <uint32_t Id>
+    struct idempotent_call
+    {
+        static const bool value = cacheable_call<Id>::value; ///< check result
+    };
+
+    /**
+     * \brief Remote pointer argument that allows server to read pointed client memory (see ipc::service_invoker::read_by_channel).
+     *
+     * It is serialized as ipc::message::remote_ptr<true>, so remote function receives ordinary remote pointer. Client answers remote reads
+     * only inside regions of readable pointers passed as arguments of the current call, plain remote pointers are not readable.
+     */
+    class readable_ptr : public message::remote_ptr<true>
+    {
+    public:
+        /**
+         * \brief Creates pointer to memory region.
+         *
+         * \param p region begin
+         * \param size region size
+         */
+        readable_ptr(const void* p, size_t size) noexcept : remote_ptr(p), m_size(size) {}
+
+        /**
+         * \brief Creates pointer to value (or whole structure).
+         *
+         * \param value pointed value
+         */
+        template <typename T>
+        explicit readable_ptr(const T* value) noexcept : readable_ptr(value, sizeof(T)) {}
+
+        /**
+         * \brief Returns region size.
+         */
+        size_t get_size() const noexcept { return m_size; }
+
+    protected:
+        size_t m_size; ///< region size
+    };
+
     /**
      * \brief Lightweight remote service call helper.
      */
     class service_invoker
     {
     public:
+        /**
+         * \brief Creates invoker without results caching.
+         */
+        service_invoker() noexcept = default;
+
+        /**
+         * \brief Creates invoker with results caching.
+         *
+         * Results of ipc::service_invoker::call_by_address calls of functions marked by ipc::cacheable_call are stored in \p cache (key is service address, function identifier and serialized arguments).
+         * Concurrent identical calls are coalesced to single remote call. Callbacks of server are dispatched for that (leader) call only: coalesced calls and cache hits 
+         * get result without dispatcher calls, so cacheable functions should not use callbacks. Cacheable functions can't have remote pointer arguments 
+         * (ipc::message::remote_ptr, ipc::readable_ptr): pointer values don't identify call, so it is checked at compile time.
+         *
+         * \param cache results cache, it must outlive invoker
+         */
+        explicit service_invoker(call_cache& cache) noexcept : m_cache(&cache) {}
+
         /**
          * \brief Calls remote service by text link.
          * 
@@ -90,6 +183,44 @@ namespace ipc
         template <uint32_t Id, typename R, typename Tuple, typename Dispatcher, typename Predicate, typename... Args>
         R call_by_address(const Tuple& address, Dispatcher& dispatcher, const Predicate& predicate, const Args&... args);
 
+        /**
+         * \brief Calls remote service by one of balanced endpoints.
+         * 
+         * Selects endpoint by \p balancer, calls it by #call_by_address and reports call result to \p balancer (only ipc::system_error based exceptions are counted as endpoint failures).
+         * Connection is established by single attempt. If all endpoints are ejected by their circuit breakers, ipc::circuit_open_exception is thrown without connection attempts.
+         *
+         * \tparam Id identifier of remote function
+         * \tparam R return value type
+         * \param balancer service endpoints
+         * \param dispatcher dispatcher routine (or function-like object) compatible with bool(uint32_t id, ipc::in_message& in_msg, ipc::out_message& out_msg)
+         * \param predicate function of type bool() or similar callable object 
+         * \param args remote service arguments
+         *
+         * \return result of remote call
+         */
+        template <uint32_t Id, typename R, typename Tuple, typename Dispatcher, typename Predicate, typename... Args>
+        R call_by_balancer(load_balancer<Tuple>& balancer, Dispatcher& dispatcher, const Predicate& predicate, const Args&... args);
+
+        /**
+         * \brief Calls idempotent remote service with hedging.
+         * 
+         * Sends request to endpoint selected by \p balancer. If there is no answer during \p percentile of recent calls latency, the same request is sent to another endpoint.
+         * The first answered connection is used to finish the call (callbacks processing included), another one is closed. If there are no latency statistics yet, 
+         * function behaves like #call_by_balancer.
+         *
+         * \tparam Id identifier of remote function (ipc::idempotent_call must be true for it)
+         * \tparam R return value type
+         * \param balancer service endpoints
+         * \param percentile latency percentile (in range [0, 1]) that is used as hedging delay
+         * \param dispatcher dispatcher routine (or function-like object) compatible with bool(uint32_t id, ipc::in_message& in_msg, ipc::out_message& out_msg)
+         * \param predicate function of type bool() or similar callable object 
+         * \param args remote service arguments
+         *
+         * \return result of remote call
+         */
+        template <uint32_t Id, typename R, typename Tuple, typename Dispatcher, typename Predicate, typename... Args>
+        R call_hedged(load_balancer<Tuple>& balancer, double percentile, Dispatcher& dispatcher, const Predicate& predicate, const Args&... args);
+
         /**
          * \brief Calls remote service by established connection.
          * 
@@ -107,6 +238,49 @@ namespace ipc
          */
         template <uint32_t Id, typename R, typename Predicate, typename... Args>
         R call_by_channel(point_to_point_socket& socket, in_message& in_msg, out_message& out_msg, const Predicate& predicate, const Args&... args);
+
+        /**
+         * \brief Reads several values (or whole structures) from client memory by established connection.
+         * 
+         * All requests are packed to the single ipc::function_invoker_base::remote_read_tag callback message, so it costs one round trip regardless of values count.
+         * Client side request is processed by ipc::service_invoker::call_by_address automatically (client dispatcher is not called).
+         *
+         * Client answers only if all values are inside regions of ipc::readable_ptr arguments of the current call and their total size doesn't exceed
+         * ipc::function_invoker_base::max_remote_read_size, otherwise it aborts the call (and connection).
+         *
+         * \tparam T types of values to read (they can't be deduced, so they must be specified explicitly), they must be trivially copyable and default constructible
+         * \param socket established connection
+         * \param in_msg input message
+         * \param out_msg output message
+         * \param predicate function of type bool() or similar callable object 
+         * \param ptrs remote pointers (ipc::message::remote_ptr<true> or ipc::readable_ptr, one per value type)
+         *
+         * \return tuple of read values
+         */
+        template <typename... T, typename Predicate, typename... Pointers>
+        std::tuple<T...> read_by_channel(point_to_point_socket& socket, in_message& in_msg, out_message& out_msg, const Predicate& predicate, const Pointers&... ptrs);
+
+        /**
+         * \brief Requests metrics of remote server (see ipc::rpc_server::enable_metrics).
+         *
+         * \param address service address (unix socket path or address and port to TCP connection)
+         * \param predicate function of type bool() or similar callable object
+         *
+         * \return server counters
+         */
+        template <typename Tuple, typename Predicate>
+        metrics_snapshot query_metrics(const Tuple& address, const Predicate& predicate);
+
+    protected:
+        /**
+         * \brief Calls remote service by text link (#call_by_address implementation).
+         *
+         * \param connect_attempts number of connection attempts
+         */
+        template <uint32_t Id, typename R, typename Tuple, typename Dispatcher, typename Predicate, typename... Args>
+        R call_by_address_proc(const Tuple& address, int connect_attempts, Dispatcher& dispatcher, const Predicate& predicate, const Args&... args);
+
+        call_cache* m_cache = nullptr; ///< results cache (optional)
     };
 
     /**
@@ -133,26 +307,153 @@ namespace ipc
          *
          * This routine creates and runs thread pool workers, each of them accepts and processes incoming requests. After successful running of workers Dispatcher::ready callback will be called.
          *
+         * If dispatcher has method bool is_idempotent(uint32_t) const that returns true for function identifier, concurrent identical requests of this function are coalesced: 
+         * only one of them is dispatched and its serialized response is sent to all waiting connections. Only functions without callbacks should be marked as idempotent. 
+         * Cached functions (see #enable_response_cache) are coalesced too.
+         *
          * \param dispatcher object that must have several methods:  invoke(uint32_t, ipc::in_message&, ipc::out_message&, ipc::point_to_point_socket&) const, void report_error(const std::exception&) const and void ready() const.
          * \param predicate predicate function (or function-like object) that allows user to stop worker threads.
          */
         template <typename Dispatcher, typename Predicate>
         void run(const Dispatcher& dispatcher, const Predicate& predicate);
 
+#ifndef _WIN32
+        /**
+         * \brief Enables remote calls processing by several worker processes (POSIX only).
+         *
+         * Current (supervisor) process forks \p processes_count workers that share listening socket, each of them runs \p threads_count threads like #run does. 
+         * Crash or hang of one dispatcher doesn't stop the whole service, and not thread safe handlers can be scaled across cores by single threaded workers.
+         * Exited workers are respawned (not faster than once per second) while \p predicate returns true. After that \p stop_signal is sent to all workers, 
+         * so they should stop when it is got (worker's \p predicate copy must return false) and supervisor waits for their termination. 
+         * Dispatcher::ready is called by supervisor once after the first workers spawning. 
+         *
+         * \note Supervisor should not have running threads at the moment of call (only calling thread exists in forked process).
+         * Slow call log can't be used by workers because its writer thread doesn't survive fork, so ipc::slow_call_log_exception is thrown if it is enabled.
+         *
+         * \param dispatcher object that must have the same methods as #run requires
+         * \param predicate predicate function (or function-like object) that allows user to stop supervisor and workers
+         * \param processes_count number of worker processes
+         * \param threads_count number of threads of each worker process
+         * \param stop_signal signal that is sent to workers by supervisor on stop
+         */
+        template <typename Dispatcher, typename Predicate>
+        void run_prefork(const Dispatcher& dispatcher, const Predicate& predicate, unsigned int processes_count, unsigned int threads_count = 1, int stop_signal = SIGTERM);
+#endif // _WIN32
+
+        /**
+         * \brief Enables responses caching.
+         *
+         * If dispatcher has method response_ttl(uint32_t) const that returns positive std::chrono::duration for function identifier, serialized responses of this function are cached 
+         * (request message is used as a key), so the next identical requests are answered by cached response without Dispatcher::invoke call.
+         * Only idempotent functions without callbacks should be cached.
+         *
+         * \param max_memory cache memory limit (in bytes)
+         * \param shards_count number of independently locked cache parts
+         */
+        void enable_response_cache(size_t max_memory, size_t shards_count = 16) { m_cache = std::make_unique<response_cache>(max_memory, shards_count); }
+
+#ifndef _WIN32
+        /**
+         * \brief Enables capturing of requests and responses (POSIX only).
+         *
+         * Each accepted connection gets its own identifier in \p log, all read and written messages (callbacks included) are appended to \p log.
+         * Captured log can be replayed by ipc-replay tool.
+         *
+         * \param log capture log, it must outlive server
+         */
+        void enable_capture(capture_log& log) noexcept { m_capture = &log; }
+#endif // _WIN32
+
+        /**
+         * \brief Enables logging of slow calls.
+         *
+         * Calls whose processing (from request reading start to response writing end) takes threshold of \p log or more are submitted to \p log 
+         * with phases durations and the first bytes of request payload. Calls are timed only while log is enabled.
+         *
+         * \param log slow call log, it must outlive server
+         */
+        void enable_slow_call_log(slow_call_log& log) noexcept { m_slow_log = &log; }
+
+        /**
+         * \brief Enables server metrics.
+         *
+         * Server counts connections, workers utilization and latency of functions (from request reading start to response writing end).
+         * Requests of reserved ipc::function_invoker_base::metrics_id function are answered by current counters without Dispatcher::invoke call 
+         * (see ipc::service_invoker::query_metrics and ipc-stats tool). Each worker process of #run_prefork has its own counters.
+         */
+        void enable_metrics() { m_metrics = std::make_unique<server_metrics>(); }
+
+        /**
+         * \brief Enables per request memory arenas.
+         *
+         * Each worker thread owns ipc::request_arena that is active while connection is processed, so messages created by Dispatcher::invoke 
+         * (including nested callback sessions) and std::pmr containers allocated by ipc::get_message_resource don't use heap, 
+         * the whole memory is released in one shot when request is finished. Objects allocated from arena must not outlive Dispatcher::invoke call.
+         *
+         * \param initial_size size of initial arena block of each worker thread
+         */
+        void enable_request_arena(size_t initial_size = 16384) noexcept { m_arena_size = (initial_size != 0 ? initial_size : 1); }
+
+#if defined(__AFUNIX_H__) && !defined(_WIN32)
+        /**
+         * \brief Enables listening socket handoff for zero downtime restart.
+         *
+         * #run listens UNIX socket \p control_path. When new server process connects to it (see ipc::take_over_listener), listening socket is sent to that process, 
+         * control socket is closed (so new process can use the same \p control_path), this server stops accepting new connections, finishes accepted ones and #run returns.
+         * Listening socket is shared by both processes during handoff, so pending and incoming connections are not refused.
+         *
+         * \param control_path handoff control UNIX socket path
+         */
+        void enable_handoff(std::string_view control_path) { m_handoff_path = control_path; }
+#endif // __AFUNIX_H__ && !_WIN32
+
     protected:
         Server_socket m_server_socket; ///< passive socket channel instance
+        std::string m_handoff_path; ///< handoff control socket path (optional)
+        std::atomic<bool> m_draining = false; ///< listening socket has been handed off, server finishes accepted connections
+#ifndef _WIN32
+        capture_log* m_capture = nullptr; ///< capture log (optional)
+#endif // _WIN32
+        slow_call_log* m_slow_log = nullptr; ///< slow call log (optional)
+        std::unique_ptr<response_cache> m_cache; ///< responses cache (optional)
+        std::unique_ptr<server_metrics> m_metrics; ///< server metrics (optional)
+        size_t m_arena_size = 0; ///< size of initial block of per request arenas (zero means arenas are disabled)
+        single_flight m_flights; ///< running calls of idempotent functions
 
         /**
          * \brief Thread pool worker routine.
          *
          * This routine accepts incomming connections, reads incoming messages, deserializes request code and forwars it to Dispatcher::invoke routine (in loop). After dispatching outcoming message will be sent back by #thread_proc.
          * #thread_proc sets top level exception handler that forwards exceptions to Dispatcher::report_error as std::exception referenses. 
+         * Request processing phases and errors are recorded to flight recorder (see ipc::record_flight_event), so Dispatcher::report_error can dump recent events by ipc::dump_flight_recorder.
          *
          * \param dispatcher object that must have several methods:  invoke(uint32_t, ipc::in_message&, ipc::out_message&, ipc::point_to_point_socket&) const, void report_error(const std::exception_ptr& p) const and void ready() const.
          * \param predicate predicate function (or function-like object) that allows user to stop worker threads.
          */
         template <typename Dispatcher, typename Predicate>
         void thread_proc(const Dispatcher* dispatcher, const Predicate* predicate);
+
+        /**
+         * \brief Runs thread pool workers and waits for them.
+         *
+         * \param dispatcher dispatcher object (see #run)
+         * \param predicate predicate function (or function-like object) that allows user to stop worker threads.
+         * \param threads_count number of worker threads
+         * \param notify Dispatcher::ready should be called after workers running
+         */
+        template <typename Dispatcher, typename Predicate>
+        void run_threads(const Dispatcher& dispatcher, const Predicate& predicate, unsigned int threads_count, bool notify);
+
+#if defined(__AFUNIX_H__) && !defined(_WIN32)
+        /**
+         * \brief Handoff control socket routine (see #enable_handoff).
+         *
+         * \param dispatcher object that receives errors by Dispatcher::report_error
+         * \param predicate predicate function (or function-like object) that allows user to stop handoff waiting.
+         */
+        template <typename Dispatcher, typename Predicate>
+        void handoff_proc(const Dispatcher* dispatcher, const Predicate* predicate);
+#endif // __AFUNIX_H__ && !_WIN32
     };
 }
 
@@ -0,0 +1,136 @@
+/**
+ * \file slowlog.hpp
+ *
+ * \brief Additional IPC library components (slow calls logging).
+ *
+ * \copyright Copyright (C) 2020 Pavel Kovalenko. All rights reserved.<br>
+ * <br>
+ * This Source Code Form is subject to the terms of the Mozilla<br>
+ * Public License, v. 2.0. If a copy of the MPL was not distributed<br>
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#ifndef __DOXYGEN__
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#endif // __DOXYGEN__
+
+#include "ipc.hpp"
+
+namespace ipc
+{
+    /**
+     * \brief Slow call log file can't be created.
+     */
+    class slow_call_log_exception : public system_error
+    {
+    public:
+        /**
+         * \brief Exception constructor
+         *
+         * \param code exception code (errno)
+         * \param message exception message
+         */
+        template <class T>
+        slow_call_log_exception(int code, T&& message) : system_error(code, std::forward<T>(message)) {}
+    };
+
+    /**
+     * \brief Slow call record.
+     *
+     * Phases durations are nanoseconds, request reading starts right after connection accepting.
+     */
+    struct slow_call
+    {
+        int64_t timestamp = 0; ///< call end time (nanoseconds since system clock epoch)
+        uint32_t function = 0; ///< remote function identifier
+        int64_t read = 0; ///< request reading duration
+        int64_t dispatch = 0; ///< request dispatching duration
+        int64_t write = 0; ///< response writing duration
+        size_t payload_size = 0; ///< request payload size (in bytes)
+        std::string payload; ///< the first bytes of request payload (function identifier and arguments)
+    };
+
+    /**
+     * \brief Log of calls that take more time than threshold (see ipc::rpc_server::enable_slow_call_log).
+     *
+     * Records are formatted and written to file by background thread, so submitting thread only copies truncated payload to bounded queue.
+     * Records over rate limit or queue capacity are dropped (number of records dropped before each written one is logged with it).
+     */
+    class slow_call_log
+    {
+    public:
+        typedef std::chrono::steady_clock clock; ///< clock used for calls timing
+
+        /**
+         * \brief Opens (or truncates) log file and starts writer thread.
+         *
+         * \param path log file path
+         * \param threshold calls that take this time or more are logged
+         * \param max_rate max number of records per second
+         * \param dump_size max number of payload bytes that are logged (as hex dump)
+         * \param queue_capacity max number of records waiting for writing
+         */
+        slow_call_log(std::string_view path, clock::duration threshold, size_t max_rate = 100, size_t dump_size = 64, size_t queue_capacity = 1024);
+        ~slow_call_log(); ///< writes queued records and stops writer thread
+
+        slow_call_log(const slow_call_log&) = delete;
+        slow_call_log& operator = (const slow_call_log&) = delete;
+
+        /**
+         * \brief Returns calls duration threshold.
+         */
+        clock::duration get_threshold() const noexcept { return m_threshold; }
+
+        /**
+         * \brief Returns max number of payload bytes that are logged.
+         */
+        size_t get_dump_size() const noexcept { return m_dump_size; }
+
+        /**
+         * \brief Queues record for writing.
+         *
+         * \param call slow call record (payload is truncated to dump size)
+         *
+         * \return false if record has been dropped because of rate limit or queue overflow
+         */
+        bool submit(slow_call&& call);
+
+        /**
+         * \brief Returns total number of dropped records.
+         */
+        uint64_t get_dropped_count() const;
+
+    protected:
+        void writer_proc(); ///< writes queued records
+
+        std::ofstream m_file; ///< log file
+        clock::duration m_threshold; ///< calls duration threshold
+        size_t m_max_rate; ///< max number of records per second
+        size_t m_dump_size; ///< max number of logged payload bytes
+        size_t m_queue_capacity; ///< max number of queued records
+
+        mutable std::mutex m_lock; ///< queue and counters lock
+        std::condition_variable m_wake; ///< wakes writer thread
+        std::vector<std::pair<slow_call, uint64_t>> m_queue; ///< records waiting for writing (with number of records dropped before them)
+        clock::time_point m_window_start; ///< current rate limiting window start
+        size_t m_window_count = 0; ///< number of records submitted in current window
+        uint64_t m_dropped = 0; ///< number of records dropped since the last submitted one
+        uint64_t m_total_dropped = 0; ///< total number of dropped records
+        bool m_stop = false; ///< writer thread should exit
+        std::thread m_writer; ///< writer thread
+    };
+}
+
+#ifndef __DOXYGEN__
+#include "../source/slowlog_impl.hpp"
+#endif // __DOXYGEN__
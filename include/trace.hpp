@@ -0,0 +1,155 @@
+/**
+ * \file trace.hpp
+ *
+ * \brief Additional IPC library components (distributed tracing).
+ *
+ * \copyright Copyright (C) 2020 Pavel Kovalenko. All rights reserved.<br>
+ * <br>
+ * This Source Code Form is subject to the terms of the Mozilla<br>
+ * Public License, v. 2.0. If a copy of the MPL was not distributed<br>
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#ifndef __DOXYGEN__
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <vector>
+#endif // __DOXYGEN__
+
+#include "trace_context.hpp"
+
+namespace ipc
+{
+    /**
+     * \brief Returns trace context of current thread (remote calls made by this thread are its children).
+     */
+    trace_context get_current_trace_context() noexcept;
+
+    /**
+     * \brief Sets trace context of current thread while instance exists (previous context is restored on destruction).
+     */
+    class trace_scope
+    {
+    public:
+        /**
+         * \brief Sets \p context as current thread context.
+         *
+         * \param context trace context
+         */
+        explicit trace_scope(const trace_context& context) noexcept;
+        ~trace_scope(); ///< restores previous context
+
+        trace_scope(const trace_scope&) = delete;
+        trace_scope& operator = (const trace_scope&) = delete;
+
+    protected:
+        trace_context m_previous; ///< previous context of current thread
+    };
+
+    /**
+     * \brief Span kinds.
+     */
+    enum class span_kind : uint8_t
+    {
+        server, ///< request processing by ipc::rpc_server
+        client ///< remote call by ipc::service_invoker
+    };
+
+    /**
+     * \brief Recorded span.
+     *
+     * Timestamps are nanoseconds since system clock epoch (they can be compared between hosts with synchronized clocks). Phases timestamps are zero for client spans.
+     */
+    struct span
+    {
+        uint64_t trace_id; ///< trace identifier
+        uint64_t span_id; ///< span identifier
+        uint64_t parent_id; ///< parent span identifier
+        uint32_t function; ///< remote function identifier
+        span_kind kind; ///< span kind
+        int64_t start; ///< request reading start (server) or call start (client)
+        int64_t read; ///< request has been read (server)
+        int64_t dispatch; ///< request has been dispatched (server)
+        int64_t end; ///< response has been written (server) or read (client)
+    };
+
+    /**
+     * \brief Returns current time in span timestamps units.
+     */
+    int64_t get_trace_time() noexcept;
+
+    /**
+     * \brief Records span to span buffer of current thread.
+     *
+     * Each thread has its own lock free ring buffer of recent spans, so recording doesn't block. The oldest spans are overwritten, buffer of finished thread is reused by the next new thread.
+     *
+     * \param s span to record
+     */
+    void record_span(const span& s) noexcept;
+
+    /**
+     * \brief Writes recorded spans of all threads (one span per text line).
+     *
+     * Spans are not removed from buffers. Spans that are being overwritten during dumping are skipped.
+     *
+     * \param stream output stream
+     */
+    void dump_spans(std::ostream& stream);
+
+    /**
+     * \brief Writes recorded spans of all threads to file (see #dump_spans(std::ostream&)).
+     *
+     * \param path file path
+     *
+     * \return true if file has been written successfully
+     */
+    bool dump_spans(std::string_view path);
+
+    /**
+     * \brief Span of remote call that is recorded on destruction.
+     *
+     * If parent context is sampled, instance creates child context and makes it current for its thread, so nested remote calls become children of this span.
+     */
+    class span_scope
+    {
+    public:
+        /**
+         * \brief Starts span.
+         *
+         * \param kind span kind
+         * \param function remote function identifier
+         * \param parent parent context
+         * \param start span start time (see ipc::get_trace_time)
+         */
+        span_scope(span_kind kind, uint32_t function, const trace_context& parent, int64_t start = get_trace_time()) noexcept;
+        ~span_scope(); ///< records span if it is sampled (and restores previous context of current thread)
+
+        span_scope(const span_scope&) = delete;
+        span_scope& operator = (const span_scope&) = delete;
+
+        /**
+         * \brief Returns span context (it should be sent to callee).
+         */
+        const trace_context& get_context() const noexcept { return m_context; }
+
+        void mark_read() noexcept { m_span.read = get_trace_time(); } ///< marks the end of request reading
+        void mark_dispatched() noexcept { m_span.dispatch = get_trace_time(); } ///< marks the end of request dispatching
+        void mark_written() noexcept { m_span.end = get_trace_time(); } ///< marks the end of response writing (span end time is destruction time otherwise)
+
+    protected:
+        trace_context m_context; ///< span context
+        trace_context m_previous; ///< previous context of current thread
+        span m_span; ///< span data
+    };
+}
+
+#ifndef __DOXYGEN__
+#include "../source/trace_impl.hpp"
+#endif // __DOXYGEN__
@@ -0,0 +1,55 @@
+/**
+ * \file trace_context.hpp
+ *
+ * \brief Additional IPC library components (trace context carried by message header).
+ *
+ * \copyright Copyright (C) 2020 Pavel Kovalenko. All rights reserved.<br>
+ * <br>
+ * This Source Code Form is subject to the terms of the Mozilla<br>
+ * Public License, v. 2.0. If a copy of the MPL was not distributed<br>
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#ifndef __DOXYGEN__
+#include <cstdint>
+#endif // __DOXYGEN__
+
+namespace ipc
+{
+    /**
+     * \brief Trace context that is carried by message header (see __MSG_USE_TRACING__).
+     *
+     * Context identifies trace (chain of remote calls started by single root call) and span (single call of the chain).
+     * Zero trace identifier means there is no trace.
+     * start() and make_child() are defined by trace.hpp, include it to begin or continue traces (ipc.hpp includes it only if __MSG_USE_TRACING__ is 1).
+     */
+    struct trace_context
+    {
+        static const uint8_t sampled = 1; ///< spans of trace should be recorded
+
+        uint64_t trace_id = 0; ///< trace identifier
+        uint64_t span_id = 0; ///< span identifier
+        uint8_t flags = 0; ///< trace flags
+
+        /**
+         * \brief Checks if spans of trace should be recorded.
+         */
+        bool is_sampled() const noexcept { return trace_id != 0 && (flags & sampled) != 0; }
+
+        /**
+         * \brief Starts new trace.
+         *
+         * \param flags trace flags
+         *
+         * \return root context of new trace
+         */
+        static trace_context start(uint8_t flags = sampled) noexcept;
+
+        /**
+         * \brief Creates context of child span (the same trace, new span identifier).
+         */
+        trace_context make_child() const noexcept;
+    };
+}
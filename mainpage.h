@@ -19,7 +19,8 @@ First of all we must create listening socket, let it be an instance of ipc::unix
 \endcode
 
 Now we are ready to process incoming connections, but first we will discuss two message classes: ipc::in_message and ipc::out_message. This classes allows us 'out of the box' to serialize several 'primitive' types in stream manner. This 'primitive' types are:
-<i>uint32_t, int32_t, uint64_t, int64_t, double, char, ipc::Message::RemotePtr, <b>string type</b> and <b>blob type</b></i>. <b>String type</b> may be any <i>std::string_view</i> compatible type (null termination is not required) for serializing and <i>std::string</i> for deserializing.
+<i>uint32_t, int32_t, uint64_t, int64_t, double, char, ipc::Message::RemotePtr, <b>string type</b> and <b>blob type</b></i>. <b>String type</b> may be any <i>std::string_view</i> compatible type (null termination is not required) for serializing and <i>std::string</i> (or <i>std::string_view</i> that refers to message buffer) for deserializing.
+Strings are zero terminated on the wire by default, length prefixed encoding (strings may contain zeros) is enabled by __MSG_LEGACY_STRINGS__ = 0 on all peers at once.
 <b>Blob type</b> is <i>std::pair<const uint8_t*, size_t></i> for serializing and <i>std::vector<uint8_t></i> or <i>std::pair<std::array<uint8_t, N>size_t></i> for deserializing. To serialize/deserialize custom data structures we should overload stream operators, here is example:
 
 \code{.cpp}
@@ -111,6 +112,10 @@ catch(const std::exception& ex)
 }
 \endcode
 
+Default constructed ipc::in_message preallocates buffer of max message length, so raw message may be copied to its buffer directly (this use is deprecated). 
+To save memory construct it with small size (e.g. ipc::message::initial_read_size): buffer grows to the length of received message, but it must be filled by read_message 
+or ipc::in_message::assign_frame only.
+
 That's all about message based communication for now. For more info you can see <i>examples/simple-message-server.cpp</i> and <i>examples/simple-message-client.cpp</i>.
 
 \page page2 RPC based communication
@@ -255,6 +260,20 @@ int main()
 
 ipc::service_invoker::call_by_address requires dispatch function (or functor): it handles callbacks from server to client. If there is no callback this routine can return false for any request, but is better to check identifier for ipc::function_invoker_base::done_tag equality and process any other code as error.
 
+If server needs many values from client memory (for example several fields of structure) it is better to use ipc::service_invoker::read_by_channel instead of callback per value: all values are requested by single callback message and client side answers it inside ipc::service_invoker::call_by_address automatically.
+Client must pass the structure as ipc::readable_ptr: only memory of such arguments of the current call can be read (requests of other memory, including plain ipc::message::remote_ptr arguments, are rejected by ipc::bad_message_exception). Client side:
+
+\code{.cpp}
+add_args args = { 3, 4 };
+auto result = ipc::service_invoker().call_by_address<(uint32_t)simple_server_function_t::add_with_remote_read, int32_t>(std::tuple{ host, port }, minimal_dispatch, minimal_predicate, ipc::readable_ptr(&args));
+\endcode
+
+Server side (argument is received as ordinary ipc::message::remote_ptr<true>):
+
+\code{.cpp}
+auto [args] = ipc::service_invoker().read_by_channel<add_args>(p2p_socket, in_msg, out_msg, predicate, p); // whole structure by one round trip
+\endcode
+
 That's all about RPC based communication for now. For more info you can see <i>examples/simple-rpc-server.cpp</i> and <i>examples/simple-rpc-client.cpp</i>. They have the same functionality as message based samples and can be swapped with them.
 
 */
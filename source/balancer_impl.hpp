@@ -0,0 +1,249 @@
+/**
+ * Lightweight inter process communication library
+ * Copyright (C) 2020 Pavel Kovalenko 
+ *
+ * This Source Code Form is subject to the terms of the Mozilla
+ * Public License, v. 2.0. If a copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+/*
+    Template methods (balancer.h) implementations. It shouldn't be used directly.
+*/
+#pragma once
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+#include "../include/balancer.hpp"
+
+namespace ipc
+{
+    inline bool circuit_breaker::is_available(clock::time_point now) const noexcept
+    {
+        if (m_state.load(std::memory_order_acquire) == state_t::closed)
+            return true;
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        return (m_state.load(std::memory_order_relaxed) == state_t::closed || m_deadline <= now);
+    }
+
+    inline bool circuit_breaker::try_acquire() noexcept
+    {
+        if (m_state.load(std::memory_order_acquire) == state_t::closed)
+            return true;
+
+        const auto now = clock::now();
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_state.load(std::memory_order_relaxed) == state_t::closed)
+            return true;
+
+        if (m_deadline > now)
+            return false;
+
+        m_state.store(state_t::half_open, std::memory_order_release); // open time (or previous trial) is over, this call is a trial
+        m_deadline = now + m_open_time;
+        return true;
+    }
+
+    inline void circuit_breaker::report(bool success) noexcept
+    {
+        if (success)
+        {
+            if (m_state.load(std::memory_order_acquire) == state_t::closed)
+            {
+                if (m_failures.load(std::memory_order_relaxed) != 0)
+                    m_failures.store(0, std::memory_order_relaxed);
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_failures.store(0, std::memory_order_relaxed);
+            m_state.store(state_t::closed, std::memory_order_release);
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            const state_t state = m_state.load(std::memory_order_relaxed);
+            if (state == state_t::half_open || (state == state_t::closed && m_failures.fetch_add(1, std::memory_order_relaxed) + 1 >= m_failures_to_open))
+            {
+                m_failures.store(0, std::memory_order_relaxed);
+                m_deadline = clock::now() + m_open_time;
+                m_state.store(state_t::open, std::memory_order_release);
+            }
+        }
+    }
+
+    inline void circuit_breaker::probe_succeeded() noexcept
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_state.load(std::memory_order_relaxed) == state_t::open)
+            m_deadline = clock::now();
+    }
+
+    template <typename Tuple>
+    inline load_balancer<Tuple>::lease::lease(load_balancer& owner, endpoint& e) noexcept : m_owner(owner), m_endpoint(&e), m_start(clock::now())
+    {
+        m_endpoint->outstanding.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    template <typename Tuple>
+    inline void load_balancer<Tuple>::lease::release() noexcept
+    {
+        if (m_endpoint != nullptr)
+        {
+            m_endpoint->outstanding.fetch_sub(1, std::memory_order_relaxed);
+            m_endpoint = nullptr;
+        }
+    }
+
+    template <typename Tuple>
+    inline void load_balancer<Tuple>::lease::complete(bool success) noexcept
+    {
+        if (m_endpoint == nullptr)
+            return;
+
+        endpoint& e = *m_endpoint;
+        if (success)
+        {
+            const int64_t sample = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - m_start).count();
+            const int64_t latency = e.latency.load(std::memory_order_relaxed);
+            e.latency.store(latency == 0 ? sample : latency + (sample - latency) / 8, std::memory_order_relaxed);
+
+            const size_t index = m_owner.m_latency_samples_written.fetch_add(1, std::memory_order_relaxed);
+            m_owner.m_latency_samples[index % latency_samples_count].store(sample, std::memory_order_relaxed);
+        }
+
+        e.breaker.report(success);
+        release();
+    }
+
+    template <typename Tuple>
+    inline load_balancer<Tuple>::load_balancer(const std::vector<Tuple>& addresses, balancing_policy policy, uint32_t failures_to_eject, clock::duration ejection_time, clock::duration probe_interval) :
+        m_policy(policy)
+    {
+        if (addresses.empty())
+            throw std::invalid_argument(std::string(__FUNCTION_NAME__) + ": endpoints list is empty");
+
+        for (const auto& address : addresses)
+            m_endpoints.push_back(std::make_unique<endpoint>(address, failures_to_eject, ejection_time));
+
+        if (probe_interval > probe_interval.zero())
+            m_prober = std::thread(&load_balancer::probe_proc, this, probe_interval);
+    }
+
+    template <typename Tuple>
+    inline load_balancer<Tuple>::~load_balancer()
+    {
+        if (m_prober.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_probe_lock);
+                m_stop = true;
+            }
+
+            m_probe_wakeup.notify_all();
+            m_prober.join();
+        }
+    }
+
+    template <typename Tuple>
+    inline void load_balancer<Tuple>::probe_proc(clock::duration interval)
+    {
+        std::unique_lock<std::mutex> lock(m_probe_lock);
+        while (!m_probe_wakeup.wait_for(lock, interval, [this] { return m_stop; }))
+        {
+            lock.unlock();
+            for (auto& e : m_endpoints)
+            {
+                if (e->breaker.get_state() != circuit_breaker::state_t::open)
+                    continue;
+
+                try
+                {
+                    make_client_socket(e->address, 1);
+                    e->breaker.probe_succeeded();
+                }
+                catch (const std::exception&) {} // endpoint is still unavailable
+            }
+
+            lock.lock();
+        }
+    }
+
+    template <typename Tuple>
+    inline bool load_balancer<Tuple>::is_better(const endpoint& a, const endpoint& b) const noexcept
+    {
+        const uint32_t a_outstanding = a.outstanding.load(std::memory_order_relaxed), b_outstanding = b.outstanding.load(std::memory_order_relaxed);
+        const int64_t a_latency = a.latency.load(std::memory_order_relaxed), b_latency = b.latency.load(std::memory_order_relaxed);
+        if (m_policy == balancing_policy::least_outstanding)
+            return (a_outstanding < b_outstanding) || (a_outstanding == b_outstanding && a_latency < b_latency);
+        else
+            return (a_latency < b_latency) || (a_latency == b_latency && a_outstanding < b_outstanding);
+    }
+
+    template <typename Tuple>
+    inline typename load_balancer<Tuple>::lease load_balancer<Tuple>::acquire()
+    {
+        return lease(*this, select(nullptr));
+    }
+
+    template <typename Tuple>
+    inline typename load_balancer<Tuple>::lease load_balancer<Tuple>::acquire_except(const lease& busy)
+    {
+        return lease(*this, (m_endpoints.size() > 1) ? select(busy.m_endpoint) : select(nullptr));
+    }
+
+    template <typename Tuple>
+    inline typename load_balancer<Tuple>::clock::duration load_balancer<Tuple>::get_latency_percentile(double percentile) const
+    {
+        const size_t count = std::min(m_latency_samples_written.load(std::memory_order_relaxed), latency_samples_count);
+        if (count == 0)
+            return clock::duration::zero();
+
+        std::array<int64_t, latency_samples_count> samples;
+        for (size_t i = 0; i < count; ++i)
+            samples[i] = m_latency_samples[i].load(std::memory_order_relaxed);
+
+        const size_t n = std::min<size_t>((size_t)(std::clamp(percentile, 0.0, 1.0) * (count - 1) + 0.5), count - 1);
+        std::nth_element(samples.begin(), samples.begin() + n, samples.begin() + count);
+
+        return std::chrono::duration_cast<clock::duration>(std::chrono::nanoseconds(samples[n]));
+    }
+
+    template <typename Tuple>
+    inline typename load_balancer<Tuple>::endpoint& load_balancer<Tuple>::select(const endpoint* busy)
+    {
+        thread_local std::minstd_rand generator(std::random_device{}());
+
+        const auto now = clock::now();
+        const size_t count = m_endpoints.size();
+        auto pick = [&](const endpoint* other) -> endpoint*
+        {
+            const size_t start = std::uniform_int_distribution<size_t>(0, count - 1)(generator);
+            for (size_t i = 0; i < count; ++i)
+            {
+                endpoint* e = m_endpoints[(start + i) % count].get();
+                if (e != other && e != busy && e->breaker.is_available(now))
+                    return e;
+            }
+
+            return nullptr;
+        };
+
+        for (size_t attempt = 0; attempt < count; ++attempt)
+        {
+            endpoint* first = pick(nullptr);
+            if (first == nullptr)
+                break;
+
+            endpoint* second = pick(first);
+            endpoint* best = (second != nullptr && is_better(*second, *first)) ? second : first;
+            if (best->breaker.try_acquire())
+                return *best;
+        }
+
+        throw circuit_open_exception(std::string(__FUNCTION_NAME__) + ": all service endpoints are unavailable");
+    }
+}
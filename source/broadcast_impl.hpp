@@ -0,0 +1,32 @@
+/**
+ * Lightweight inter process communication library
+ * Copyright (C) 2020 Pavel Kovalenko
+ *
+ * This Source Code Form is subject to the terms of the Mozilla
+ * Public License, v. 2.0. If a copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+/*
+    Inline methods (broadcast.h) implementations. It shouldn't be used directly.
+*/
+#pragma once
+
+#include <thread>
+
+#include "../include/broadcast.hpp"
+
+namespace ipc
+{
+    template <typename Predicate>
+    inline void broadcast_receiver::receive(in_message& message, const Predicate& predicate)
+    {
+        while (!try_receive(message))
+        {
+            if (!predicate())
+                throw user_stop_request_exception(__FUNCTION_NAME__);
+
+            std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,160 @@
+/**
+ * Lightweight inter process communication library
+ * Copyright (C) 2020 Pavel Kovalenko 
+ *
+ * This Source Code Form is subject to the terms of the Mozilla
+ * Public License, v. 2.0. If a copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+/*
+    Template and inline methods (cache.h) implementations. It shouldn't be used directly.
+*/
+#pragma once
+
+#include <algorithm>
+
+#include "../include/cache.hpp"
+
+namespace ipc
+{
+    inline response_cache::response_cache(size_t max_memory, size_t shards_count) : 
+        m_shards(new shard[std::max<size_t>(shards_count, 1)]), 
+        m_shards_count(std::max<size_t>(shards_count, 1)), 
+        m_shard_limit(max_memory / std::max<size_t>(shards_count, 1))
+    {
+    }
+
+    inline response_cache::shard& response_cache::get_shard(std::string_view key) noexcept
+    {
+        return m_shards[std::hash<std::string_view>()(key) % m_shards_count];
+    }
+
+    inline void response_cache::erase(shard& s, std::list<entry>::iterator it) noexcept
+    {
+        s.used -= entry_size(it->key.size(), it->frame->size());
+        s.index.erase(it->key);
+        s.lru.erase(it);
+    }
+
+    inline response_cache::frame_ptr response_cache::find(std::string_view key)
+    {
+        shard& s = get_shard(key);
+        std::lock_guard<std::mutex> lock(s.lock);
+
+        auto it = s.index.find(key);
+        if (it == s.index.end())
+            return nullptr;
+
+        if (it->second->expiration <= clock::now())
+        {
+            erase(s, it->second);
+            return nullptr;
+        }
+
+        s.lru.splice(s.lru.begin(), s.lru, it->second);
+        return it->second->frame;
+    }
+
+    inline void response_cache::insert(std::string key, frame_ptr frame, clock::duration ttl)
+    {
+        const size_t size = entry_size(key.size(), frame->size());
+        if (size > m_shard_limit)
+            return;
+
+        const auto expiration = clock::now() + ttl;
+        shard& s = get_shard(key);
+        std::lock_guard<std::mutex> lock(s.lock);
+
+        auto it = s.index.find(key);
+        if (it != s.index.end())
+            erase(s, it->second);
+
+        s.lru.push_front(entry{ std::move(key), std::move(frame), expiration });
+        s.index.emplace(s.lru.front().key, s.lru.begin());
+        s.used += size;
+
+        while (s.used > m_shard_limit)
+            erase(s, std::prev(s.lru.end()));
+    }
+
+    inline void response_cache::clear() noexcept
+    {
+        for (size_t i = 0; i < m_shards_count; ++i)
+        {
+            std::lock_guard<std::mutex> lock(m_shards[i].lock);
+            m_shards[i].index.clear();
+            m_shards[i].lru.clear();
+            m_shards[i].used = 0;
+        }
+    }
+
+    inline size_t response_cache::get_memory_usage() noexcept
+    {
+        size_t used = 0;
+        for (size_t i = 0; i < m_shards_count; ++i)
+        {
+            std::lock_guard<std::mutex> lock(m_shards[i].lock);
+            used += m_shards[i].used;
+        }
+
+        return used;
+    }
+
+    template <typename Producer>
+    inline single_flight::frame_ptr single_flight::run(std::string key, Producer&& producer)
+    {
+        std::shared_future<frame_ptr> running;
+        std::promise<frame_ptr> promise;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            auto it = m_calls.find(key);
+            if (it != m_calls.end())
+                running = it->second;
+            else
+                m_calls.emplace(key, promise.get_future().share());
+        }
+
+        if (running.valid())
+            return running.get();
+
+        try
+        {
+            frame_ptr result = producer();
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_calls.erase(key);
+            }
+
+            promise.set_value(result);
+            return result;
+        }
+        catch (...)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_calls.erase(key);
+            }
+
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+
+    template <typename Producer>
+    inline call_cache::frame_ptr call_cache::get(std::string key, Producer&& producer)
+    {
+        if (auto frame = m_cache.find(key))
+            return frame;
+
+        return m_flights.run(key, [this, &key, &producer]
+            {
+                if (auto frame = m_cache.find(key))
+                    return frame;
+
+                frame_ptr frame = producer();
+                m_cache.insert(key, frame, m_ttl);
+                return frame;
+            });
+    }
+}
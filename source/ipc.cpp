@@ -9,6 +9,8 @@
 
 #include <algorithm>
 #include <boost/filesystem.hpp>
+#include <chrono>
+#include <new>
 #include <string.h>
 #include <thread>
 
@@ -17,6 +19,13 @@
 #include <netdb.h>
 #endif 
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif // _WIN32
+
+#include "../include/broadcast.hpp"
+#include "../include/capture.hpp"
 #include "../include/ipc.hpp"
 
 namespace ipc
@@ -114,19 +123,47 @@ namespace ipc
     {
         super::close();
         if (!m_link.empty())
+        {
             unlink(m_link.c_str());
+            m_link.clear(); // the same path can be bound by another process after close
+        }
+    }
+
+#ifndef _WIN32
+    void point_to_point_socket::send_handle(socket_t handle)
+    {
+        check_status<bad_socket_exception>(m_ok, __FUNCTION_NAME__);
+
+        char data = 0;
+        iovec io = { &data, sizeof(data) };
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(socket_t))] = {};
+
+        msghdr msg = {};
+        msg.msg_iov = &io;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        cmsghdr* header = CMSG_FIRSTHDR(&msg);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(socket_t));
+        memcpy(CMSG_DATA(header), &handle, sizeof(socket_t));
+
+        if (sendmsg(m_socket, &msg, 0) != sizeof(data))
+            fail_status<socket_write_exception>(m_ok, get_socket_error(), __FUNCTION_NAME__);
     }
+#endif // _WIN32
 
 #endif //__AFUNIX_H__
 
-    void client_socket::connect_proc(const sockaddr* address, size_t size)
+    void client_socket::connect_proc(const sockaddr* address, size_t size, int max_attempts)
     {
         if (INVALID_SOCKET == m_socket)
             fail_status<active_socket_prepare_exception>(m_ok, get_socket_error(), std::string(__FUNCTION_NAME__) + ": unable to allocate socket");
 
-        const int max_attempts_count = 10;
         int attempt = 0;
-        for (; attempt < max_attempts_count && connect(m_socket, address, size) < 0; ++attempt)
+        for (; attempt < max_attempts && connect(m_socket, address, size) < 0; ++attempt)
         {
             int err_code = get_socket_error();
 #ifdef _WIN32
@@ -135,20 +172,23 @@ namespace ipc
             if (err_code == EAGAIN || err_code == ECONNREFUSED || err_code == EINPROGRESS)
 #endif
             {
+                if (attempt + 1 == max_attempts)
+                    fail_status<active_socket_prepare_exception>(m_ok, err_code, std::string(__FUNCTION_NAME__) + ": unable to connect");
+
                 std::this_thread::sleep_for(std::chrono::seconds(1)); // TODO: fix me
             }
             else
                 fail_status<active_socket_prepare_exception>(m_ok, err_code, std::string(__FUNCTION_NAME__) + ": unable to connect");
         }
 
-        if (attempt == max_attempts_count)
+        if (attempt == max_attempts)
             fail_status<active_socket_prepare_exception>(m_ok, get_socket_error(), std::string(__FUNCTION_NAME__) + ": unable to connect");
 
         if (!set_non_blocking_mode(m_socket))
             fail_status<active_socket_prepare_exception>(m_ok, get_socket_error(), std::string(__FUNCTION_NAME__) + ": unable to enable non blocking mode");
     }
 
-    void tcp_client_socket::connect_proc(uint32_t address, uint16_t port)
+    void tcp_client_socket::connect_proc(uint32_t address, uint16_t port, int max_attempts)
     {
         sockaddr_in serv_addr = {};
         serv_addr.sin_family = AF_INET;
@@ -156,12 +196,12 @@ namespace ipc
         serv_addr.sin_addr.s_addr = htonl(address);
 
         m_socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-        super::connect_proc((const sockaddr*)&serv_addr, sizeof(serv_addr));
+        super::connect_proc((const sockaddr*)&serv_addr, sizeof(serv_addr), max_attempts);
     }
 
-    tcp_client_socket::tcp_client_socket(uint32_t address, uint16_t port) : client_socket(INVALID_SOCKET)
+    tcp_client_socket::tcp_client_socket(uint32_t address, uint16_t port, int max_attempts) : client_socket(INVALID_SOCKET)
     {
-        connect_proc(address, port);
+        connect_proc(address, port, max_attempts);
     }
 
 #ifdef _WIN32
@@ -170,7 +210,7 @@ namespace ipc
     static inline int get_h_socket_error() noexcept { return h_errno; }
 #endif // _WIN32
 
-    tcp_client_socket::tcp_client_socket(std::string_view address, uint16_t port) : client_socket(INVALID_SOCKET)
+    tcp_client_socket::tcp_client_socket(std::string_view address, uint16_t port, int max_attempts) : client_socket(INVALID_SOCKET)
     {
         auto info = gethostbyname(address.data());
         if (info == nullptr)
@@ -179,7 +219,7 @@ namespace ipc
         if (info->h_addrtype != AF_INET || info->h_addr_list[0] == nullptr)
             fail_status<bad_hostname_exception>(m_ok, std::string(__FUNCTION_NAME__) + ": unable to get information about host IP address");
 
-        connect_proc(ntohl(*(u_long*)info->h_addr_list[0]), port);
+        connect_proc(ntohl(*(u_long*)info->h_addr_list[0]), port, max_attempts);
     }
 
 #ifdef _WIN32
@@ -195,7 +235,7 @@ namespace ipc
 #endif
 
 #ifdef __AFUNIX_H__
-    unix_client_socket::unix_client_socket(std::string_view path) : client_socket(INVALID_SOCKET)
+    unix_client_socket::unix_client_socket(std::string_view path, int max_attempts) : client_socket(INVALID_SOCKET)
     {
         if (!is_socket_exists(path.data()))
         {
@@ -212,7 +252,7 @@ namespace ipc
         strncpy(serv_addr.sun_path, path.data(), std::min<size_t>(sizeof(serv_addr.sun_path), path.size()));
 
         m_socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
-        super::connect_proc((const sockaddr*)&serv_addr, offsetof(sockaddr_un, sun_path) + path.size());
+        super::connect_proc((const sockaddr*)&serv_addr, offsetof(sockaddr_un, sun_path) + path.size(), max_attempts);
     }
 
 #endif //__AFUNIX_H__
@@ -248,6 +288,123 @@ namespace ipc
         throw container_overflow_exception(std::move(msg));
     }
 
+    static thread_local std::pmr::memory_resource* message_resource = nullptr; // nullptr means heap
+
+    std::pmr::memory_resource* get_message_resource() noexcept
+    {
+        return message_resource != nullptr ? message_resource : std::pmr::new_delete_resource();
+    }
+
+    request_arena::request_arena(size_t initial_size) : 
+        m_initial(new char[std::max<size_t>(initial_size, 1)]), 
+        m_resource(m_initial.get(), std::max<size_t>(initial_size, 1), std::pmr::new_delete_resource())
+    {
+    }
+
+    request_arena::scope::scope(request_arena& arena) noexcept : m_arena(arena), m_previous(message_resource)
+    {
+        message_resource = m_arena.get_resource();
+    }
+
+    request_arena::scope::~scope()
+    {
+        message_resource = m_previous;
+        m_arena.m_resource.release();
+    }
+
+    segmented_out_message::segmented_out_message() : m_resource(get_message_resource()), m_size(0)
+    {
+        m_segments.push_back((char*)m_resource->allocate(segment_size, alignof(std::max_align_t)));
+        clear();
+    }
+
+    segmented_out_message::~segmented_out_message()
+    {
+        for (char* segment : m_segments)
+            m_resource->deallocate(segment, segment_size, alignof(std::max_align_t));
+    }
+
+    void segmented_out_message::clear() noexcept
+    {
+        m_ok = true;
+        memset(m_segments.front(), 0, header_size);
+        m_size = header_size;
+        *(__MSG_LENGTH_TYPE__*)m_segments.front() = header_size;
+    }
+
+    void segmented_out_message::append(const char* data, size_t size)
+    {
+        while (size != 0)
+        {
+            const size_t index = m_size / segment_size, offset = m_size % segment_size;
+            if (index == m_segments.size())
+                m_segments.push_back((char*)m_resource->allocate(segment_size, alignof(std::max_align_t)));
+
+            const size_t chunk = std::min(size, segment_size - offset);
+            memcpy(m_segments[index] + offset, data, chunk);
+            m_size += chunk;
+            data += chunk;
+            size -= chunk;
+        }
+    }
+
+    void segmented_out_message::begin_field(const char* func_name, size_t field_size)
+    {
+        check_status<bad_message_exception>(m_ok, std::string(func_name) + ": fail flag is set");
+
+        const size_t new_used = m_size + field_size;
+        if (new_used > get_max_size())
+            fail_status(throw_message_overflow_exception, m_ok, func_name, new_used, get_max_size());
+
+        *(__MSG_LENGTH_TYPE__*)m_segments.front() = (__MSG_LENGTH_TYPE__)new_used;
+    }
+
+    segmented_out_message& segmented_out_message::operator << (const std::string_view& s)
+    {
+#if __MSG_USE_TAGS__
+        begin_field(__FUNCTION_NAME__, s.length() + string_prefix_size + string_suffix_size + 1); // tag
+        const char tag = (char)type_tag::str;
+        append(&tag, 1);
+#else
+        begin_field(__FUNCTION_NAME__, s.length() + string_prefix_size + string_suffix_size);
+#endif // __MSG_USE_TAGS__
+#if __MSG_LEGACY_STRINGS__
+        append(s.data(), s.length());
+        append("", 1); // string_view is not necessarily null terminated, so we set it explicitly
+#else
+        const __MSG_LENGTH_TYPE__ len = (__MSG_LENGTH_TYPE__)s.length();
+        append((const char*)&len, sizeof(len));
+        append(s.data(), s.length());
+#endif // __MSG_LEGACY_STRINGS__
+        return *this;
+    }
+
+    segmented_out_message& segmented_out_message::operator << (const std::pair<const uint8_t*, size_t>& blob)
+    {
+#if __MSG_USE_TAGS__
+        begin_field(__FUNCTION_NAME__, blob.second + 1 + sizeof(__MSG_LENGTH_TYPE__)); // tag and blob length
+        const char tag = (char)type_tag::blob;
+        append(&tag, 1);
+#else
+        begin_field(__FUNCTION_NAME__, blob.second + sizeof(__MSG_LENGTH_TYPE__)); // blob length only
+#endif // __MSG_USE_TAGS__
+        const __MSG_LENGTH_TYPE__ blob_len = (__MSG_LENGTH_TYPE__)blob.second;
+        append((const char*)&blob_len, sizeof(blob_len));
+        append((const char*)blob.first, blob.second);
+        return *this;
+    }
+
+    void segmented_out_message::flatten(message_buffer& buffer) const
+    {
+        buffer.clear();
+        buffer.reserve(m_size);
+        for (size_t i = 0; i < get_segments_count(); ++i)
+        {
+            const std::string_view segment = get_segment(i);
+            buffer.append(segment.data(), segment.data() + segment.size());
+        }
+    }
+
 #if __MSG_USE_TAGS__
     const char* ipc::message::to_string(type_tag t) noexcept
     {
@@ -282,9 +439,9 @@ namespace ipc
         check_status<bad_message_exception>(m_ok, std::string(__FUNCTION_NAME__) + ": fail flag is set");
 
 #if __MSG_USE_TAGS__
-        const size_t delta = 2; // terminating '\0' and tag
+        const size_t delta = string_prefix_size + string_suffix_size + 1; // length or terminating '\0' and tag
 #else
-        const size_t delta = 1; // terminating '\0' only
+        const size_t delta = string_prefix_size + string_suffix_size; // length or terminating '\0' only
 #endif // __MSG_USE_TAGS__
         const char* arg = s.data();
         const size_t len = s.length();
@@ -297,9 +454,15 @@ namespace ipc
 #if __MSG_USE_TAGS__
             m_buffer.push_back((char)type_tag::str);
 #endif // __MSG_USE_TAGS__
-            m_buffer.insert(m_buffer.end(), arg, arg + len);
+#if __MSG_LEGACY_STRINGS__
+            m_buffer.append(arg, arg + len);
             m_buffer.push_back('\0'); // string_view is not necessarily null terminated, so we set it explicitly
-            *(__MSG_LENGTH_TYPE__*)m_buffer.data() += (__MSG_LENGTH_TYPE__)new_used;
+#else
+            const __MSG_LENGTH_TYPE__ str_len = (__MSG_LENGTH_TYPE__)len;
+            m_buffer.append((const char*)&str_len, (const char*)(&str_len + 1));
+            m_buffer.append(arg, arg + len);
+#endif // __MSG_LEGACY_STRINGS__
+            *(__MSG_LENGTH_TYPE__*)m_buffer.data() = (__MSG_LENGTH_TYPE__)new_used;
         }
         
         return *this;
@@ -310,9 +473,9 @@ namespace ipc
         check_status<bad_message_exception>(m_ok, std::string(__FUNCTION_NAME__) + ": fail flag is set");
 
 #if __MSG_USE_TAGS__
-        const size_t delta = 1;
+        const size_t delta = 1 + sizeof(__MSG_LENGTH_TYPE__); // tag and blob length
 #else
-        const size_t delta = 0;
+        const size_t delta = sizeof(__MSG_LENGTH_TYPE__); // blob length only
 #endif // __MSG_USE_TAGS__
         const uint8_t* arg = blob.first;
         const size_t len = blob.second;
@@ -326,24 +489,33 @@ namespace ipc
             m_buffer.push_back((char)type_tag::blob);
 #endif // __MSG_USE_TAGS__
             const __MSG_LENGTH_TYPE__ blob_len = (__MSG_LENGTH_TYPE__)len;
-            m_buffer.insert(m_buffer.end(), (const char*)&blob_len, (const char*)(&blob_len + 1));
-            m_buffer.insert(m_buffer.end(), arg, arg + len);
-            *(__MSG_LENGTH_TYPE__*)m_buffer.data() += (__MSG_LENGTH_TYPE__)new_used;
+            m_buffer.append((const char*)&blob_len, (const char*)(&blob_len + 1));
+            m_buffer.append((const char*)arg, (const char*)arg + len);
+            *(__MSG_LENGTH_TYPE__*)m_buffer.data() = (__MSG_LENGTH_TYPE__)new_used;
         }
 
         return *this;
     }
 
     in_message& in_message::operator >> (std::string& arg)
+    {
+        arg.clear();
+        std::string_view view;
+        *this >> view;
+        arg.assign(view.data(), view.length());
+
+        return *this;
+    }
+
+    in_message& in_message::operator >> (std::string_view& arg)
     {
         check_status<bad_message_exception>(m_ok, std::string(__FUNCTION_NAME__) + ": fail flag is set");
 
-        arg.clear();
         __MSG_LENGTH_TYPE__ size = *(__MSG_LENGTH_TYPE__*)m_buffer.data();
 #if __MSG_USE_TAGS__
-        const size_t delta = 2; /*termination '\0' and type tag*/
+        const size_t delta = string_prefix_size + string_suffix_size + 1; /*length or termination '\0' and type tag*/
 #else
-        const size_t delta = 1; /*termination '\0' only*/
+        const size_t delta = string_prefix_size + string_suffix_size; /*length or termination '\0' only*/
 #endif // __MSG_USE_TAGS__
         if (size < m_offset + delta)
             fail_status(throw_message_too_short_exception, m_ok, __FUNCTION_NAME__, m_offset + delta, size);
@@ -356,6 +528,7 @@ namespace ipc
         ++m_offset;
 #endif // __MSG_USE_TAGS__
 
+#if __MSG_LEGACY_STRINGS__
         const char* begin = &m_buffer[m_offset];
         const char* end = (const char*)memchr(begin, 0, size - m_offset);
         if (end == nullptr)
@@ -366,9 +539,159 @@ namespace ipc
             throw container_overflow_exception(std::move(msg));
         }
 
-        arg.assign(begin, end - begin);
-        m_offset += arg.length() + 1;
+        const size_t len = end - begin;
+#else
+        const size_t len = *(const __MSG_LENGTH_TYPE__*)&m_buffer[m_offset];
+        m_offset += string_prefix_size;
+        if (size < m_offset + len)
+            fail_status(throw_message_too_short_exception, m_ok, __FUNCTION_NAME__, m_offset + len, size);
+#endif // __MSG_LEGACY_STRINGS__
+
+        arg = std::string_view(&m_buffer[m_offset], len);
+        m_offset += len + string_suffix_size;
+
+        return *this;
+    }
+
+#if __MSG_USE_TAGS__
+    size_t in_message::get_field_size(size_t offset, size_t size)
+    {
+        const type_tag tag = (type_tag)m_buffer[offset];
+        size_t field = 1; // type tag
+        switch (tag)
+        {
+        case type_tag::u32:
+        case type_tag::i32:
+            field += sizeof(uint32_t);
+            break;
+        case type_tag::u64:
+        case type_tag::i64:
+        case type_tag::fp64:
+        case type_tag::remote_ptr:
+        case type_tag::const_remote_ptr:
+            field += sizeof(uint64_t);
+            break;
+        case type_tag::chr:
+            field += sizeof(char);
+            break;
+        case type_tag::str:
+#if __MSG_LEGACY_STRINGS__
+        {
+            const char* begin = &m_buffer[offset + 1];
+            const char* end = (const char*)memchr(begin, 0, size - offset - 1);
+            if (end == nullptr)
+                fail_status(throw_message_too_short_exception, m_ok, __FUNCTION_NAME__, size + 1, size);
+
+            field += end - begin + 1;
+            break;
+        }
+#else
+            [[fallthrough]]; // length prefixed string has the same layout as blob
+#endif // __MSG_LEGACY_STRINGS__
+        case type_tag::blob:
+            if (size < offset + field + sizeof(__MSG_LENGTH_TYPE__))
+                fail_status(throw_message_too_short_exception, m_ok, __FUNCTION_NAME__, offset + field + sizeof(__MSG_LENGTH_TYPE__), size);
+
+            field += sizeof(__MSG_LENGTH_TYPE__) + *(const __MSG_LENGTH_TYPE__*)&m_buffer[offset + 1];
+            break;
+        default:
+            fail_status(throw_type_mismatch_exception, m_ok, __FUNCTION_NAME__, to_string(tag), "known type");
+        }
+
+        if (size < offset + field)
+            fail_status(throw_message_too_short_exception, m_ok, __FUNCTION_NAME__, offset + field, size);
+
+        return field;
+    }
+
+    size_t in_message::build_index()
+    {
+        check_status<bad_message_exception>(m_ok, std::string(__FUNCTION_NAME__) + ": fail flag is set");
+
+        m_index.clear();
+        const size_t size = *(const __MSG_LENGTH_TYPE__*)m_buffer.data();
+        for (size_t offset = header_size; offset < size; offset += get_field_size(offset, size))
+            m_index.push_back((__MSG_LENGTH_TYPE__)offset);
+
+        return m_index.size();
+    }
+
+    in_message& in_message::seek(size_t field)
+    {
+        check_status<bad_message_exception>(m_ok, std::string(__FUNCTION_NAME__) + ": fail flag is set");
+
+        if (field >= m_index.size())
+            fail_status<message_too_short_exception>(m_ok, std::string(__FUNCTION_NAME__) + ": field " + std::to_string(field) + " is not indexed (" + std::to_string(m_index.size()) + " fields)");
+
+        m_offset = m_index[field];
+        return *this;
+    }
+#endif // __MSG_USE_TAGS__
+
+    void in_message::validate(const field_signature* signature, size_t count, bool exact)
+    {
+        check_status<bad_message_exception>(m_ok, std::string(__FUNCTION_NAME__) + ": fail flag is set");
+
+        const size_t size = *(const __MSG_LENGTH_TYPE__*)m_buffer.data();
+        size_t offset = m_offset;
+        for (const field_signature* field = signature; field != signature + count; ++field)
+        {
+#if __MSG_USE_TAGS__
+            if (size <= offset)
+                fail_status(throw_message_too_short_exception, m_ok, __FUNCTION_NAME__, offset + 1, size);
+
+            const type_tag tag = (type_tag)m_buffer[offset];
+            if (!is_compatible_tags(tag, field->tag))
+                fail_status(throw_type_mismatch_exception, m_ok, __FUNCTION_NAME__, to_string(tag), to_string(field->tag));
+
+            ++offset;
+#endif // __MSG_USE_TAGS__
+            size_t data_size = field->size;
+#if __MSG_LEGACY_STRINGS__
+            if (field->tag == type_tag::str)
+            {
+                const char* begin = &m_buffer[offset];
+                const char* end = (const char*)memchr(begin, 0, size - offset);
+                if (end == nullptr)
+                    fail_status(throw_message_too_short_exception, m_ok, __FUNCTION_NAME__, size + 1, size);
+
+                data_size = end - begin + 1;
+            }
+            else if (field->tag == type_tag::blob)
+#else
+            if (field->tag == type_tag::str || field->tag == type_tag::blob)
+#endif // __MSG_LEGACY_STRINGS__
+            {
+                if (size < offset + sizeof(__MSG_LENGTH_TYPE__))
+                    fail_status(throw_message_too_short_exception, m_ok, __FUNCTION_NAME__, offset + sizeof(__MSG_LENGTH_TYPE__), size);
+
+                data_size = *(const __MSG_LENGTH_TYPE__*)&m_buffer[offset];
+                if (data_size > field->size)
+                    fail_status(throw_container_overflow_exception, m_ok, __FUNCTION_NAME__, data_size, field->size);
+
+                data_size += sizeof(__MSG_LENGTH_TYPE__);
+            }
+
+            offset += data_size;
+            if (size < offset)
+                fail_status(throw_message_too_short_exception, m_ok, __FUNCTION_NAME__, offset, size);
+        }
+
+        if (exact && offset != size)
+            fail_status<type_mismach_exception>(m_ok, std::string(__FUNCTION_NAME__) + ": " + std::to_string(size - offset) + " bytes of unexpected data after the last field");
+    }
+
+    out_message& out_message::append_fields(std::string_view fields)
+    {
+        check_status<bad_message_exception>(m_ok, std::string(__FUNCTION_NAME__) + ": fail flag is set");
+
+        const size_t used = *(__MSG_LENGTH_TYPE__*)m_buffer.data();
+        const size_t new_used = used + fields.size();
+        if (new_used > get_max_size())
+            fail_status(throw_message_overflow_exception, m_ok, __FUNCTION_NAME__, new_used, get_max_size());
 
+        m_buffer.append(fields.data(), fields.data() + fields.size());
+        *(__MSG_LENGTH_TYPE__*)m_buffer.data() = (__MSG_LENGTH_TYPE__)new_used;
         return *this;
     }
 
@@ -408,4 +731,339 @@ namespace ipc
 
         return *this;
     }
+
+#ifndef _WIN32
+    struct capture_log::header
+    {
+        char magic[8];
+        std::atomic<uint64_t> used;
+        std::atomic<uint64_t> connections;
+        std::atomic<uint64_t> dropped;
+    };
+
+    struct capture_log::record
+    {
+        uint32_t length; // record length (header and alignment included)
+        std::atomic<uint32_t> committed;
+        uint64_t connection_id;
+        int64_t timestamp;
+        uint8_t written;
+        uint8_t reserved[7];
+    };
+
+    static const char capture_magic[8] = { 'I', 'P', 'C', 'C', 'A', 'P', '0', '1' };
+
+    capture_log::capture_log(std::string_view path, size_t capacity) : m_path(path), m_file(-1), m_size(sizeof(header) + capacity), m_data(nullptr)
+    {
+        m_file = open(m_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (m_file < 0)
+            throw capture_log_exception(errno, std::string(__FUNCTION_NAME__) + ": unable to create " + m_path);
+
+        void* data = MAP_FAILED;
+        if (ftruncate(m_file, m_size) == 0)
+            data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+
+        if (data == MAP_FAILED)
+        {
+            const int code = errno;
+            ::close(m_file);
+            throw capture_log_exception(code, std::string(__FUNCTION_NAME__) + ": unable to map " + m_path);
+        }
+
+        m_data = (char*)data;
+        header* h = new (m_data) header{};
+        memcpy(h->magic, capture_magic, sizeof(capture_magic));
+    }
+
+    capture_log::~capture_log()
+    {
+        const size_t used = std::min<uint64_t>(((header*)m_data)->used.load(std::memory_order_acquire), m_size - sizeof(header));
+        munmap(m_data, m_size);
+        [[maybe_unused]] const int truncated = ftruncate(m_file, sizeof(header) + used); // log is still readable if truncation fails (unused space is zeroed)
+
+        ::close(m_file);
+    }
+
+    bool capture_log::append(uint64_t connection_id, const char* message, bool written) noexcept
+    {
+        header* h = (header*)m_data;
+        const size_t message_size = *(const __MSG_LENGTH_TYPE__*)message;
+        const size_t length = (sizeof(record) + message_size + alignof(record) - 1) & ~(alignof(record) - 1);
+        const size_t offset = h->used.fetch_add(length, std::memory_order_relaxed);
+        if (offset + length > m_size - sizeof(header))
+        {
+            h->dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        char* data = m_data + sizeof(header) + offset;
+        record* r = new (data) record{};
+        r->length = (uint32_t)length;
+        r->connection_id = connection_id;
+        r->timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        r->written = written;
+        memcpy(data + sizeof(record), message, message_size);
+        r->committed.store(1, std::memory_order_release);
+
+        return true;
+    }
+
+    uint64_t capture_log::make_connection_id() noexcept
+    {
+        return ((header*)m_data)->connections.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    uint64_t capture_log::get_dropped_count() const noexcept
+    {
+        return ((const header*)m_data)->dropped.load(std::memory_order_relaxed);
+    }
+
+    void point_to_point_socket::capture_message(const char* message, bool written) noexcept
+    {
+        m_capture->append(m_connection_id, message, written);
+    }
+
+    capture_reader::capture_reader(std::string_view path) : m_size(0), m_end(0), m_offset(sizeof(capture_log::header)), m_data(nullptr)
+    {
+        const std::string file_path(path);
+        const int file = open(file_path.c_str(), O_RDONLY);
+        if (file < 0)
+            throw capture_log_exception(errno, std::string(__FUNCTION_NAME__) + ": unable to open " + file_path);
+
+        struct stat info = {};
+        void* data = MAP_FAILED;
+        if (fstat(file, &info) == 0 && (size_t)info.st_size >= sizeof(capture_log::header))
+            data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+        const int code = errno;
+        ::close(file);
+        if (data == MAP_FAILED)
+            throw capture_log_exception(code, std::string(__FUNCTION_NAME__) + ": unable to map " + file_path);
+
+        m_data = (char*)data;
+        m_size = info.st_size;
+        const auto* h = (const capture_log::header*)m_data;
+        if (memcmp(h->magic, capture_magic, sizeof(capture_magic)) != 0)
+        {
+            munmap(m_data, m_size);
+            throw capture_log_exception(EINVAL, std::string(__FUNCTION_NAME__) + ": " + file_path + " is not a capture log");
+        }
+
+        m_end = std::min<uint64_t>(m_size, sizeof(capture_log::header) + h->used.load(std::memory_order_acquire));
+    }
+
+    capture_reader::~capture_reader()
+    {
+        munmap(m_data, m_size);
+    }
+
+    bool capture_reader::next(capture_record& r) noexcept
+    {
+        while (m_offset + sizeof(capture_log::record) <= m_end)
+        {
+            const auto* rec = (const capture_log::record*)(m_data + m_offset);
+            if (rec->length < sizeof(capture_log::record) || m_offset + rec->length > m_end)
+                return false; // writer has been terminated during appending
+
+            const char* message = m_data + m_offset + sizeof(capture_log::record);
+            m_offset += rec->length;
+            if (rec->committed.load(std::memory_order_acquire) == 0)
+                continue;
+
+            r.connection_id = rec->connection_id;
+            r.timestamp = rec->timestamp;
+            r.written = (rec->written != 0);
+            r.message = std::string_view(message, std::min<size_t>(*(const __MSG_LENGTH_TYPE__*)message, rec->length - sizeof(capture_log::record)));
+            return true;
+        }
+
+        return false;
+    }
+
+    struct broadcast_channel::header
+    {
+        char magic[8];
+        uint64_t capacity; // ring size
+        alignas(64) std::atomic<uint64_t> reserved; // end of record that is being written (data before reserved - capacity is intact)
+        std::atomic<uint64_t> oldest; // position of the oldest intact record
+        std::atomic<uint64_t> position; // end of the last written record
+        std::atomic<uint64_t> published; // number of published messages
+    };
+
+    struct alignas(16) broadcast_channel::record // alignment is not less than size, so padding record always fits the rest of ring
+    {
+        uint32_t size; // record size (header and alignment included)
+        uint32_t padding; // non zero if record only skips the rest of ring
+        uint64_t sequence; // message sequence number
+    };
+
+    static const char broadcast_magic[8] = { 'I', 'P', 'C', 'B', 'C', 'S', '0', '1' };
+
+    broadcast_channel::broadcast_channel(std::string_view path, size_t capacity) : m_path(path), m_file(-1), m_size(0), m_data(nullptr), m_position(0), m_oldest(0)
+    {
+        capacity = (capacity + alignof(record) - 1) & ~(alignof(record) - 1);
+        m_size = sizeof(header) + capacity;
+
+        unlink(m_path.c_str()); // receivers of previous channel keep their mapping of old file
+        m_file = open(m_path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (m_file < 0)
+            throw broadcast_channel_exception(errno, std::string(__FUNCTION_NAME__) + ": unable to create " + m_path);
+
+        void* data = MAP_FAILED;
+        if (ftruncate(m_file, m_size) == 0)
+            data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+
+        if (data == MAP_FAILED)
+        {
+            const int code = errno;
+            ::close(m_file);
+            throw broadcast_channel_exception(code, std::string(__FUNCTION_NAME__) + ": unable to map " + m_path);
+        }
+
+        m_data = (char*)data;
+        header* h = new (m_data) header{};
+        h->capacity = capacity;
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(h->magic, broadcast_magic, sizeof(broadcast_magic));
+    }
+
+    broadcast_channel::~broadcast_channel()
+    {
+        munmap(m_data, m_size);
+        ::close(m_file);
+    }
+
+    void broadcast_channel::write_record(size_t size, const char* message) noexcept
+    {
+        header* h = (header*)m_data;
+        const size_t capacity = m_size - sizeof(header);
+        char* data = m_data + sizeof(header) + m_position % capacity;
+
+        const uint64_t end = m_position + size;
+        while (end > capacity && m_oldest < end - capacity) // records that are overwritten are skipped
+        {
+            record r;
+            memcpy(&r, m_data + sizeof(header) + m_oldest % capacity, sizeof(r));
+            m_oldest += r.size;
+        }
+
+        h->oldest.store(m_oldest, std::memory_order_relaxed);
+        h->reserved.store(m_position + size, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release); // receivers see reservation before overwritten data
+
+        record r = { (uint32_t)size, message == nullptr, 0 };
+        if (message != nullptr)
+        {
+            r.sequence = h->published.load(std::memory_order_relaxed);
+            memcpy(data + sizeof(record), message, *(const __MSG_LENGTH_TYPE__*)message);
+            h->published.store(r.sequence + 1, std::memory_order_relaxed);
+        }
+
+        memcpy(data, &r, sizeof(r));
+        m_position += size;
+        h->position.store(m_position, std::memory_order_release);
+    }
+
+    void broadcast_channel::publish(const char* message)
+    {
+        const size_t capacity = m_size - sizeof(header);
+        const size_t message_size = *(const __MSG_LENGTH_TYPE__*)message;
+        const size_t size = (sizeof(record) + message_size + alignof(record) - 1) & ~(alignof(record) - 1);
+        if (size > capacity)
+            throw message_overflow_exception(std::string(__FUNCTION_NAME__) + ": message doesn't fit broadcast channel");
+
+        const size_t left = capacity - m_position % capacity;
+        if (left < size)
+            write_record(left, nullptr); // records are contiguous, so the rest of ring is skipped
+
+        write_record(size, message);
+    }
+
+    uint64_t broadcast_channel::get_published_count() const noexcept
+    {
+        return ((const header*)m_data)->published.load(std::memory_order_relaxed);
+    }
+
+    broadcast_receiver::broadcast_receiver(std::string_view path) : m_size(0), m_capacity(0), m_data(nullptr), m_position(0), m_sequence((uint64_t)-1)
+    {
+        const std::string file_path(path);
+        const int file = open(file_path.c_str(), O_RDONLY);
+        if (file < 0)
+            throw broadcast_channel_exception(errno, std::string(__FUNCTION_NAME__) + ": unable to open " + file_path);
+
+        struct stat info = {};
+        void* data = MAP_FAILED;
+        if (fstat(file, &info) == 0 && (size_t)info.st_size >= sizeof(broadcast_channel::header))
+            data = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, file, 0);
+
+        const int code = errno;
+        ::close(file);
+        if (data == MAP_FAILED)
+            throw broadcast_channel_exception(code, std::string(__FUNCTION_NAME__) + ": unable to map " + file_path);
+
+        m_data = (const char*)data;
+        m_size = info.st_size;
+        const auto* h = (const broadcast_channel::header*)m_data;
+        if (memcmp(h->magic, broadcast_magic, sizeof(broadcast_magic)) != 0 || h->capacity != m_size - sizeof(broadcast_channel::header))
+        {
+            munmap((void*)m_data, m_size);
+            throw broadcast_channel_exception(EINVAL, std::string(__FUNCTION_NAME__) + ": " + file_path + " is not a broadcast channel");
+        }
+
+        m_capacity = h->capacity;
+        m_position = h->position.load(std::memory_order_acquire);
+    }
+
+    broadcast_receiver::~broadcast_receiver()
+    {
+        munmap((void*)m_data, m_size);
+    }
+
+    bool broadcast_receiver::try_receive(in_message& message)
+    {
+        const auto* h = (const broadcast_channel::header*)m_data;
+        uint64_t position = h->position.load(std::memory_order_acquire);
+        while (m_position != position)
+        {
+            const size_t offset = m_position % m_capacity;
+            const char* data = m_data + sizeof(broadcast_channel::header) + offset;
+            broadcast_channel::record r;
+            memcpy(&r, data, sizeof(r));
+
+            bool valid = position - m_position <= m_capacity && r.size >= sizeof(r) && r.size <= m_capacity - offset;
+            __MSG_LENGTH_TYPE__ length = 0;
+            if (valid && r.padding == 0)
+            {
+                memcpy(&length, data + sizeof(r), sizeof(length));
+                valid = length >= sizeof(length) && sizeof(r) + length <= r.size;
+                if (valid)
+                {
+                    message.clear();
+                    message.get_data().assign(data + sizeof(r), data + sizeof(r) + length);
+                }
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire); // reservation is checked after data copying (seqlock)
+            if (!valid || h->reserved.load(std::memory_order_relaxed) - m_position > m_capacity)
+            {
+                message.clear();
+                m_position = h->oldest.load(std::memory_order_acquire); // record has been overwritten, receiving is resumed from the oldest intact record
+                position = h->position.load(std::memory_order_acquire);
+                continue;
+            }
+
+            m_position += r.size;
+            if (r.padding != 0)
+                continue;
+
+            if (m_sequence != (uint64_t)-1)
+                m_lost += r.sequence - m_sequence;
+
+            m_sequence = r.sequence + 1;
+            return true;
+        }
+
+        return false;
+    }
+#endif // _WIN32
 }
@@ -13,6 +13,12 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <initializer_list>
+#include <tuple>
+
 #include "../include/ipc.hpp"
 
 #ifndef __FUNCTION_NAME__
@@ -61,6 +67,42 @@ namespace ipc
     static inline int get_socket_error() noexcept { return errno; }
     #endif
     
+    template<typename Predicate>
+    static int wait_for_any(std::initializer_list<socket_t> sockets, std::chrono::microseconds limit, const Predicate& predicate)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + limit;
+        while (true)
+        {
+            if (!predicate())
+                throw user_stop_request_exception(__FUNCTION_NAME__);
+
+            const auto left = std::max<std::chrono::microseconds>(std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now()), 
+                std::chrono::microseconds::zero()); // sockets are checked at least once (zero limit means polling)
+
+            fd_set fds;
+            FD_ZERO(&fds);
+            for (socket_t s : sockets)
+                FD_SET(s, &fds);
+
+            const auto wait_time = std::min<std::chrono::microseconds>(left, std::chrono::seconds(1));
+            timeval timeout = { (long)(wait_time.count() / 1000000), (long)(wait_time.count() % 1000000) };
+            const int count = select(FD_SETSIZE, &fds, nullptr, nullptr, &timeout);
+            if (count < 0)
+                throw socket_read_exception(get_socket_error(), __FUNCTION_NAME__);
+
+            int index = 0;
+            for (socket_t s : sockets)
+            {
+                if (FD_ISSET(s, &fds))
+                    return index;
+                ++index;
+            }
+
+            if (left.count() == 0)
+                return -1;
+        }
+    }
+
     template<typename Predicate>
     inline point_to_point_socket server_socket::accept(const Predicate& predicate)
     {
@@ -116,9 +158,18 @@ namespace ipc
 
     template<typename Predicate>
     inline bool point_to_point_socket::read_message(std::vector<char>& message, const Predicate& predicate)
+    {
+        return read_frame(message, predicate);
+    }
+
+    template <typename Buffer, typename Predicate>
+    inline bool point_to_point_socket::read_frame(Buffer& message, const Predicate& predicate)
     {
         check_status<bad_socket_exception>(m_ok, __FUNCTION_NAME__);
 
+        if (message.size() < sizeof(__MSG_LENGTH_TYPE__))
+            message.resize(message::initial_read_size);
+
         size_t read = 0;
         size_t size = (size_t)(-1);
         while (read < std::min<size_t>(message.size(), size))
@@ -126,7 +177,7 @@ namespace ipc
             if (!wait_for<true>(m_socket, predicate))
                 fail_status<socket_read_exception>(m_ok, get_socket_error(), __FUNCTION_NAME__);
     
-            int result = recv(m_socket, message.data() + read, message.size() - read, 0);
+            int result = recv(m_socket, message.data() + read, std::min<size_t>(message.size(), size) - read, 0);
             if (result < 0)
             {
 #ifdef __unix__
@@ -139,13 +190,30 @@ namespace ipc
             else if (result != 0)
             {
                 read += (uint32_t)result;
-                if (read >= sizeof(__MSG_LENGTH_TYPE__))
+                if (size == (size_t)(-1) && read >= sizeof(__MSG_LENGTH_TYPE__))
+                {
                     size = *(__MSG_LENGTH_TYPE__*)message.data();
+                    if (size < sizeof(__MSG_LENGTH_TYPE__)) // length prefix is a part of message
+                        fail_status<bad_message_exception>(m_ok, std::string(__FUNCTION_NAME__) + ": bad message length");
+
+                    if (size > msg_max_length) // buffer is not enlarged by corrupted or hostile prefix
+                        fail_status<message_overflow_exception>(m_ok, std::string(__FUNCTION_NAME__) + ": message is too long");
+
+                    if (message.size() < size)
+                        message.resize(size); // buffer is sized by length prefix
+                }
             }
+            else if (read == 0)
+                fail_status<connection_closed_exception>(m_ok, 0, std::string(__FUNCTION_NAME__) + ": connection has been closed by peer");
             else
                 break;
         }
     
+#ifndef _WIN32
+        if (m_capture != nullptr && read == size)
+            capture_message(message.data(), false);
+#endif // _WIN32
+
         return update_status<socket_read_exception>(m_ok, read == size, get_socket_error(), __FUNCTION_NAME__);
     }
     
@@ -154,14 +222,27 @@ namespace ipc
     {
         check_status<bad_socket_exception>(m_ok, __FUNCTION_NAME__);
 
+        const size_t length = *(const __MSG_LENGTH_TYPE__*)message;
+        size_t offset = 0; // first unsent byte (socket buffer of slow peer may accept only part of message)
         do
         {
             if (!wait_for<false>(m_socket, predicate))
                 return fail_status<socket_write_exception>(m_ok, get_socket_error(), __FUNCTION_NAME__);
 
-            int result = send(m_socket, message, *(const __MSG_LENGTH_TYPE__*)message, 0);
+            int result = send(m_socket, message + offset, (int)(length - offset), 0);
             if (result >= 0)
+            {
+                offset += result;
+                if (offset < length)
+                    continue;
+
+#ifndef _WIN32
+                if (m_capture != nullptr)
+                    capture_message(message, true);
+#endif // _WIN32
+
                 return true;
+            }
             else
             {
                 const int err = get_socket_error();
@@ -177,12 +258,159 @@ namespace ipc
         } while (true);
     }
     
+    template<typename Predicate>
+    inline bool point_to_point_socket::write_message(const segmented_out_message& message, const Predicate& predicate)
+    {
+        check_status<bad_socket_exception>(m_ok, __FUNCTION_NAME__);
+
+        constexpr size_t max_buffers = 16; // segments passed to one call
+        const size_t count = message.get_segments_count();
+        size_t segment = 0, offset = 0; // first unsent byte
+        while (segment < count)
+        {
+            if (!wait_for<false>(m_socket, predicate))
+                return fail_status<socket_write_exception>(m_ok, get_socket_error(), __FUNCTION_NAME__);
+
+#ifdef _WIN32
+            std::array<WSABUF, max_buffers> buffers;
+#else
+            std::array<iovec, max_buffers> buffers;
+#endif // _WIN32
+            size_t used = 0;
+            for (size_t i = segment; i < count && used < max_buffers; ++i, ++used)
+            {
+                const std::string_view data = message.get_segment(i).substr(i == segment ? offset : 0);
+#ifdef _WIN32
+                buffers[used].buf = (char*)data.data();
+                buffers[used].len = (ULONG)data.size();
+#else
+                buffers[used].iov_base = (void*)data.data();
+                buffers[used].iov_len = data.size();
+#endif // _WIN32
+            }
+
+#ifdef _WIN32
+            DWORD sent = 0;
+            const bool result = (WSASend(m_socket, buffers.data(), (DWORD)used, &sent, 0, nullptr, nullptr) == 0);
+#else
+            msghdr header = {};
+            header.msg_iov = buffers.data();
+            header.msg_iovlen = used;
+            const ssize_t sent = sendmsg(m_socket, &header, 0);
+            const bool result = (sent >= 0);
+#endif // _WIN32
+            if (!result)
+            {
+                const int err = get_socket_error();
+    #ifdef _WIN32
+                if (err == WSAEWOULDBLOCK)
+    #else
+                if (err == EAGAIN || err == EWOULDBLOCK)
+    #endif
+                    continue;
+    
+                return fail_status<socket_write_exception>(m_ok, get_socket_error(), __FUNCTION_NAME__);
+            }
+
+            for (size_t left = (size_t)sent; left != 0 && segment < count;)
+            {
+                const size_t available = message.get_segment(segment).size() - offset;
+                if (left < available)
+                {
+                    offset += left;
+                    break;
+                }
+
+                left -= available;
+                offset = 0;
+                ++segment;
+            }
+        }
+
+#ifndef _WIN32
+        if (m_capture != nullptr)
+        {
+            message_buffer frame;
+            message.flatten(frame);
+            capture_message(frame.data(), true);
+        }
+#endif // _WIN32
+
+        return true;
+    }
+
     inline void point_to_point_socket::shutdown() noexcept
     {
         ::shutdown(m_socket, SD_SEND);
         m_ok = false;
     }
 
+#if defined(__AFUNIX_H__) && !defined(_WIN32)
+    template<typename Predicate>
+    inline socket_t point_to_point_socket::receive_handle(const Predicate& predicate)
+    {
+        check_status<bad_socket_exception>(m_ok, __FUNCTION_NAME__);
+
+        do
+        {
+            if (!wait_for<true>(m_socket, predicate))
+                fail_status<socket_read_exception>(m_ok, get_socket_error(), __FUNCTION_NAME__);
+
+            char data = 0;
+            iovec io = { &data, sizeof(data) };
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof(socket_t))] = {};
+
+            msghdr msg = {};
+            msg.msg_iov = &io;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+
+            const ssize_t result = recvmsg(m_socket, &msg, 0);
+            if (result < 0)
+            {
+                const int err = get_socket_error();
+                if (err == EAGAIN || err == EWOULDBLOCK)
+                    continue;
+
+                fail_status<socket_read_exception>(m_ok, err, __FUNCTION_NAME__);
+            }
+
+            if (result == 0)
+                fail_status<connection_closed_exception>(m_ok, 0, std::string(__FUNCTION_NAME__) + ": connection has been closed by peer");
+
+            const cmsghdr* header = CMSG_FIRSTHDR(&msg);
+            if (header == nullptr || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS || header->cmsg_len != CMSG_LEN(sizeof(socket_t)))
+                fail_status<socket_read_exception>(m_ok, 0, std::string(__FUNCTION_NAME__) + ": socket handle has not been received");
+
+            socket_t handle = INVALID_SOCKET;
+            memcpy(&handle, CMSG_DATA(header), sizeof(socket_t));
+            return handle;
+        } while (true);
+    }
+
+    template<typename Predicate>
+    inline inherited_socket take_over_listener(std::string_view control_path, const Predicate& predicate, int max_attempts)
+    {
+        unix_client_socket control(control_path, max_attempts);
+        return inherited_socket{ control.receive_handle(predicate) };
+    }
+#endif // __AFUNIX_H__ && !_WIN32
+
+#ifdef __AFUNIX_H__
+    template <typename T>
+    static inline auto make_client_socket(const std::tuple<T>& tuple, int max_attempts = client_socket::default_connect_attempts)
+    {
+        return ipc::unix_client_socket(std::get<0>(tuple), max_attempts);
+    }
+#endif // __AFUNIX_H__
+
+    template <typename T1, typename T2>
+    static inline auto make_client_socket(const std::tuple<T1, T2>& tuple, int max_attempts = client_socket::default_connect_attempts)
+    {
+        return ipc::tcp_client_socket(std::get<0>(tuple), std::get<1>(tuple), max_attempts);
+    }
+
     template <>
     struct message::tag_traits<uint32_t>
     {
@@ -244,6 +472,48 @@ namespace ipc
         static const message::type_tag value = message::type_tag::const_remote_ptr;
     };
 
+    template <typename T>
+    struct message::field_traits<T, std::enable_if_t<trivial_type<T>::value>>
+    {
+        static constexpr bool known = true;
+        static constexpr field_signature value = { message::tag_traits<T>::value, sizeof(T) };
+    };
+
+    template <bool ConstPtr>
+    struct message::field_traits<message::remote_ptr<ConstPtr>>
+    {
+        static constexpr bool known = true;
+        static constexpr field_signature value = { ConstPtr ? message::type_tag::const_remote_ptr : message::type_tag::remote_ptr, sizeof(uint64_t) };
+    };
+
+    template <>
+    struct message::field_traits<std::string>
+    {
+        static constexpr bool known = true;
+        static constexpr field_signature value = { message::type_tag::str, msg_max_length };
+    };
+
+    template <>
+    struct message::field_traits<std::string_view>
+    {
+        static constexpr bool known = true;
+        static constexpr field_signature value = { message::type_tag::str, msg_max_length };
+    };
+
+    template <>
+    struct message::field_traits<std::vector<uint8_t>>
+    {
+        static constexpr bool known = true;
+        static constexpr field_signature value = { message::type_tag::blob, msg_max_length };
+    };
+
+    template <size_t N>
+    struct message::field_traits<std::pair<std::array<uint8_t, N>, size_t>>
+    {
+        static constexpr bool known = true;
+        static constexpr field_signature value = { message::type_tag::blob, N };
+    };
+
     [[noreturn]] void throw_message_overflow_exception(const char* func_name, size_t req_size, size_t total_size);
     [[noreturn]] void throw_type_mismatch_exception(const char* func_name, const char* tag, const char* expected);
     [[noreturn]] void throw_message_too_short_exception(const char* func_name, size_t req_size, size_t total_size);
@@ -275,26 +545,245 @@ namespace ipc
         m_buffer.push_back((char)Tag);
     #endif // __MSG_USE_TAGS__
         const char* data = (const char*)&arg;
-        m_buffer.insert(m_buffer.end(), data, data + sizeof(T));
+        m_buffer.append(data, data + sizeof(T));
         *(__MSG_LENGTH_TYPE__*)m_buffer.data() = (__MSG_LENGTH_TYPE__)new_used;
     
         return *this;
     }
     
+    template <message::type_tag Tag, typename T, typename>
+    inline segmented_out_message& segmented_out_message::push(T arg)
+    {
+    #if __MSG_USE_TAGS__
+        begin_field(__FUNCTION_NAME__, sizeof(T) + 1);
+        const char tag = (char)Tag;
+        append(&tag, 1);
+    #else
+        begin_field(__FUNCTION_NAME__, sizeof(T));
+    #endif // __MSG_USE_TAGS__
+        append((const char*)&arg, sizeof(T));
+        return *this;
+    }
+
+    inline message_buffer::message_buffer(message_buffer&& other) noexcept : message_buffer()
+    {
+        *this = std::move(other);
+    }
+
+    inline message_buffer& message_buffer::operator = (message_buffer&& other) noexcept
+    {
+        if (this == &other)
+            return *this;
+
+        release();
+        if (other.is_inline())
+            memcpy(m_data, other.m_data, other.m_size);
+        else
+        {
+            m_resource = other.m_resource;
+            m_data = other.m_data;
+            m_capacity = other.m_capacity;
+            other.m_data = other.m_inline.data();
+            other.m_capacity = inline_capacity;
+        }
+
+        m_size = other.m_size;
+        other.m_size = 0;
+        return *this;
+    }
+
+    inline void message_buffer::release() noexcept
+    {
+        if (!is_inline())
+            m_resource->deallocate(m_data, m_capacity, alignof(std::max_align_t));
+
+        m_data = m_inline.data();
+        m_capacity = inline_capacity;
+    }
+
+    inline void message_buffer::reserve(size_t capacity)
+    {
+        if (capacity <= m_capacity)
+            return;
+
+        char* data = (char*)m_resource->allocate(capacity, alignof(std::max_align_t));
+        memcpy(data, m_data, m_size);
+        if (!is_inline())
+            m_resource->deallocate(m_data, m_capacity, alignof(std::max_align_t));
+
+        m_data = data;
+        m_capacity = capacity;
+    }
+
+    inline void message_buffer::assign(size_t count, char value)
+    {
+        reserve(count);
+        memset(m_data, value, count);
+        m_size = count;
+    }
+
+    inline void message_buffer::assign(const char* first, const char* last)
+    {
+        m_size = 0;
+        append(first, last);
+    }
+
+    inline void message_buffer::resize(size_t size)
+    {
+        reserve(size);
+        m_size = size;
+    }
+
+    inline void message_buffer::shrink_to_fit()
+    {
+        if (is_inline() || m_size == m_capacity)
+            return;
+
+        message_buffer shrunk;
+        shrunk.m_resource = m_resource;
+        shrunk.assign(m_data, m_data + m_size);
+        *this = std::move(shrunk);
+    }
+
+    inline void message_buffer::swap(message_buffer& other) noexcept
+    {
+        message_buffer temp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(temp);
+    }
+
+    inline void message_buffer::push_back(char value)
+    {
+        if (m_size == m_capacity)
+            reserve(m_capacity * 2);
+
+        m_data[m_size++] = value;
+    }
+
+    inline void message_buffer::append(const char* first, const char* last)
+    {
+        const size_t count = (size_t)(last - first);
+        if (m_size + count > m_capacity)
+            reserve(std::max(m_size + count, m_capacity * 2));
+
+        memcpy(m_data + m_size, first, count);
+        m_size += count;
+    }
+
     inline void out_message::clear() noexcept
     {
-        m_buffer.resize(sizeof(__MSG_LENGTH_TYPE__));
-        *(__MSG_LENGTH_TYPE__*)m_buffer.data() = sizeof(__MSG_LENGTH_TYPE__);
+        m_buffer.assign(header_size, 0);
+        *(__MSG_LENGTH_TYPE__*)m_buffer.data() = header_size;
         m_ok = true;
     }
     
     inline void in_message::clear() noexcept
     {
-        *(__MSG_LENGTH_TYPE__*)m_buffer.data() = sizeof(__MSG_LENGTH_TYPE__);
+        *(__MSG_LENGTH_TYPE__*)m_buffer.data() = header_size;
         m_ok = true;
-        m_offset = sizeof(__MSG_LENGTH_TYPE__);
+        m_offset = header_size;
+        m_index.clear();
+    }
+
+    inline void in_message::assign_frame(const char* frame)
+    {
+        const size_t length = *(const __MSG_LENGTH_TYPE__*)frame;
+        check_status<bad_message_exception>(length >= sizeof(__MSG_LENGTH_TYPE__), std::string(__FUNCTION_NAME__) + ": bad message length");
+
+        clear();
+        m_buffer.assign(frame, frame + length);
+    }
+
+    inline out_message::out_message(out_message&& other) noexcept : message(std::move(other)), m_buffer(std::move(other.m_buffer))
+    {
+        other.clear();
+    }
+
+    inline out_message& out_message::operator = (out_message&& other) noexcept
+    {
+        if (this != &other)
+        {
+            m_ok = other.m_ok;
+            m_buffer = std::move(other.m_buffer);
+            other.clear();
+        }
+
+        return *this;
+    }
+
+    inline void out_message::swap(out_message& other) noexcept
+    {
+        std::swap(m_ok, other.m_ok);
+        m_buffer.swap(other.m_buffer);
     }
 
+    inline in_message::in_message(in_message&& other) noexcept : message(std::move(other)), m_buffer(std::move(other.m_buffer)), m_offset(other.m_offset), m_index(std::move(other.m_index))
+    {
+        other.m_buffer.resize(initial_read_size); // moved out buffer is inline
+        other.clear();
+    }
+
+    inline in_message& in_message::operator = (in_message&& other) noexcept
+    {
+        if (this != &other)
+        {
+            m_ok = other.m_ok;
+            m_offset = other.m_offset;
+            m_buffer = std::move(other.m_buffer);
+            m_index = std::move(other.m_index);
+            other.m_buffer.resize(initial_read_size); // moved out buffer is inline
+            other.clear();
+        }
+
+        return *this;
+    }
+
+    inline void in_message::swap(in_message& other) noexcept
+    {
+        std::swap(m_ok, other.m_ok);
+        std::swap(m_offset, other.m_offset);
+        m_buffer.swap(other.m_buffer);
+        m_index.swap(other.m_index);
+    }
+
+#if __MSG_USE_TRACING__
+    static inline void write_trace_header(char* header, const trace_context& context) noexcept
+    {
+        header += sizeof(__MSG_LENGTH_TYPE__);
+        memcpy(header, &context.trace_id, sizeof(uint64_t));
+        memcpy(header + sizeof(uint64_t), &context.span_id, sizeof(uint64_t));
+        header[sizeof(uint64_t) * 2] = (char)context.flags;
+    }
+
+    static inline trace_context read_trace_header(const char* header) noexcept
+    {
+        trace_context context;
+        header += sizeof(__MSG_LENGTH_TYPE__);
+        memcpy(&context.trace_id, header, sizeof(uint64_t));
+        memcpy(&context.span_id, header + sizeof(uint64_t), sizeof(uint64_t));
+        context.flags = (uint8_t)header[sizeof(uint64_t) * 2];
+        return context;
+    }
+
+    inline void out_message::set_trace_context(const trace_context& context) noexcept
+    {
+        write_trace_header(m_buffer.data(), context);
+    }
+
+    inline trace_context out_message::get_trace_context() const noexcept
+    {
+        return read_trace_header(m_buffer.data());
+    }
+
+    inline trace_context in_message::get_trace_context() const noexcept
+    {
+        if (*(const __MSG_LENGTH_TYPE__*)m_buffer.data() < header_size)
+            return trace_context();
+
+        return read_trace_header(m_buffer.data());
+    }
+#endif // __MSG_USE_TRACING__
+
 #if __MSG_USE_TAGS__
     inline constexpr bool message::is_compatible_tags(type_tag source, type_tag target) noexcept
     {
@@ -342,7 +831,9 @@ namespace ipc
         message.clear();
         try
         {
-            return read_message(message.get_data(), predicate);
+            auto& data = message.get_data();
+            data.resize(data.capacity()); // the whole available storage can be used by the first read
+            return read_frame(data, predicate);
         }
         catch (...)
         {
@@ -392,4 +883,75 @@ namespace ipc
     
         return *this;
     }
+
+    template <typename... Args>
+    inline in_message& in_message::validate(bool exact)
+    {
+        static_assert(can_validate<Args...>, "fields of given types can't be validated");
+
+        if constexpr (sizeof...(Args) != 0)
+        {
+            static constexpr field_signature signature[] = { field_traits<Args>::value... };
+            validate(signature, sizeof...(Args), exact);
+        }
+        else
+            validate(nullptr, 0, exact);
+
+        return *this;
+    }
+
+    template <typename T, typename>
+    inline in_message& in_message::get_unchecked(T& arg) noexcept
+    {
+#if __MSG_USE_TAGS__
+        ++m_offset; // type tag
+#endif // __MSG_USE_TAGS__
+        memcpy(&arg, &m_buffer[m_offset], sizeof(T));
+        m_offset += sizeof(T);
+        return *this;
+    }
+
+    inline std::string_view in_message::get_unchecked_data([[maybe_unused]] bool string) noexcept
+    {
+#if __MSG_USE_TAGS__
+        ++m_offset; // type tag
+#endif // __MSG_USE_TAGS__
+#if __MSG_LEGACY_STRINGS__
+        if (string)
+        {
+            const std::string_view s(&m_buffer[m_offset]); // terminating zero has been found by validation
+            m_offset += s.length() + 1;
+            return s;
+        }
+#endif // __MSG_LEGACY_STRINGS__
+
+        const size_t len = *(const __MSG_LENGTH_TYPE__*)&m_buffer[m_offset];
+        m_offset += sizeof(__MSG_LENGTH_TYPE__);
+        const std::string_view data(&m_buffer[m_offset], len);
+        m_offset += len;
+        return data;
+    }
+
+    inline in_message& in_message::get_unchecked(std::string& arg)
+    {
+        const std::string_view s = get_unchecked_data(true);
+        arg.assign(s.data(), s.length());
+        return *this;
+    }
+
+    inline in_message& in_message::get_unchecked(std::vector<uint8_t>& blob)
+    {
+        const std::string_view data = get_unchecked_data(false);
+        blob.assign((const uint8_t*)data.data(), (const uint8_t*)data.data() + data.size());
+        return *this;
+    }
+
+    template <size_t N>
+    inline in_message& in_message::get_unchecked(std::pair<std::array<uint8_t, N>, size_t>& blob) noexcept
+    {
+        const std::string_view data = get_unchecked_data(false);
+        memcpy(blob.first.data(), data.data(), data.size());
+        blob.second = data.size();
+        return *this;
+    }
 }
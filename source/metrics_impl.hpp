@@ -0,0 +1,150 @@
+/**
+ * Lightweight inter process communication library
+ * Copyright (C) 2020 Pavel Kovalenko
+ *
+ * This Source Code Form is subject to the terms of the Mozilla
+ * Public License, v. 2.0. If a copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+/*
+    Inline methods (metrics.h) implementations. It shouldn't be used directly.
+*/
+#pragma once
+
+#include <algorithm>
+
+#include "../include/metrics.hpp"
+
+namespace ipc
+{
+    inline void metrics_snapshot::serialize(out_message& msg) const
+    {
+        msg << uptime << workers << active_connections << busy_time << connections << errors << untracked_calls << cache_memory << (uint32_t)functions.size();
+        for (const auto& f : functions)
+            msg << f.function << f.calls << f.total << f.max << f.p50 << f.p99;
+    }
+
+    inline void metrics_snapshot::deserialize(in_message& msg)
+    {
+        uint32_t count = 0;
+        msg >> uptime >> workers >> active_connections >> busy_time >> connections >> errors >> untracked_calls >> cache_memory >> count;
+
+        functions.clear();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            function_metrics f;
+            msg >> f.function >> f.calls >> f.total >> f.max >> f.p50 >> f.p99;
+            functions.push_back(f);
+        }
+    }
+
+    inline server_metrics::connection_scope::connection_scope(server_metrics* metrics) noexcept : m_metrics(metrics)
+    {
+        if (m_metrics != nullptr)
+        {
+            m_start = clock::now();
+            m_metrics->m_connections.fetch_add(1, std::memory_order_relaxed);
+            m_metrics->m_active.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    inline server_metrics::connection_scope::~connection_scope()
+    {
+        if (m_metrics != nullptr)
+        {
+            m_metrics->m_active.fetch_sub(1, std::memory_order_relaxed);
+            m_metrics->m_busy_time.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - m_start).count(), std::memory_order_relaxed);
+        }
+    }
+
+    inline server_metrics::function_slot* server_metrics::find_slot(uint32_t function) noexcept
+    {
+        const uint64_t key = (uint64_t)function + 1;
+        for (size_t i = 0, index = (size_t)((function * 2654435761u) % max_functions); i < max_functions; ++i, index = (index + 1) % max_functions)
+        {
+            function_slot& slot = m_functions[index];
+            uint64_t current = slot.key.load(std::memory_order_acquire);
+            if (current == 0 && slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel))
+                return &slot;
+
+            if (current == key)
+                return &slot;
+        }
+
+        return nullptr;
+    }
+
+    inline void server_metrics::record_call(uint32_t function, clock::duration latency) noexcept
+    {
+        function_slot* slot = find_slot(function);
+        if (slot == nullptr)
+        {
+            m_untracked.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        const uint64_t ns = (uint64_t)std::max<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count(), 0);
+        size_t bucket = 0;
+        while (bucket + 1 < histogram_size && (ns >> bucket) > 1)
+            ++bucket;
+
+        slot->calls.fetch_add(1, std::memory_order_relaxed);
+        slot->total.fetch_add(ns, std::memory_order_relaxed);
+        slot->histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t max = slot->max.load(std::memory_order_relaxed);
+        while (ns > max && !slot->max.compare_exchange_weak(max, ns, std::memory_order_relaxed));
+    }
+
+    inline metrics_snapshot server_metrics::get_snapshot(uint64_t cache_memory) const
+    {
+        metrics_snapshot s;
+        s.uptime = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - m_start).count();
+        s.workers = (uint64_t)std::max<int64_t>(m_workers.load(std::memory_order_relaxed), 0);
+        s.active_connections = (uint64_t)std::max<int64_t>(m_active.load(std::memory_order_relaxed), 0);
+        s.busy_time = m_busy_time.load(std::memory_order_relaxed);
+        s.connections = m_connections.load(std::memory_order_relaxed);
+        s.errors = m_errors.load(std::memory_order_relaxed);
+        s.untracked_calls = m_untracked.load(std::memory_order_relaxed);
+        s.cache_memory = cache_memory;
+
+        for (const auto& slot : m_functions)
+        {
+            const uint64_t key = slot.key.load(std::memory_order_acquire);
+            if (key == 0)
+                continue;
+
+            std::array<uint64_t, histogram_size> histogram;
+            uint64_t counted = 0;
+            for (size_t i = 0; i < histogram_size; ++i)
+                counted += (histogram[i] = slot.histogram[i].load(std::memory_order_relaxed));
+
+            if (counted == 0)
+                continue;
+
+            auto percentile = [&histogram, counted](double p) -> uint64_t
+            {
+                const uint64_t rank = std::max<uint64_t>((uint64_t)(p * counted + 0.5), 1);
+                uint64_t seen = 0;
+                for (size_t i = 0; i < histogram_size; ++i)
+                    if ((seen += histogram[i]) >= rank)
+                        return (uint64_t)1 << (i + 1);
+
+                return (uint64_t)1 << histogram_size;
+            };
+
+            function_metrics f;
+            f.function = (uint32_t)(key - 1);
+            f.calls = slot.calls.load(std::memory_order_relaxed);
+            f.total = slot.total.load(std::memory_order_relaxed);
+            f.max = slot.max.load(std::memory_order_relaxed);
+            f.p50 = std::min(percentile(0.5), f.max);
+            f.p99 = std::min(percentile(0.99), f.max);
+            s.functions.push_back(f);
+        }
+
+        std::sort(s.functions.begin(), s.functions.end(), [](const function_metrics& a, const function_metrics& b) { return a.function < b.function; });
+        return s;
+    }
+}
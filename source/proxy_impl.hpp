@@ -0,0 +1,244 @@
+/**
+ * Lightweight inter process communication library
+ * Copyright (C) 2020 Pavel Kovalenko
+ *
+ * This Source Code Form is subject to the terms of the Mozilla
+ * Public License, v. 2.0. If a copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+/*
+    Inline methods (proxy.h) implementations. It shouldn't be used directly.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <iterator>
+#include <system_error>
+
+#ifdef __linux__
+#   include <fcntl.h>
+#endif // __linux__
+
+#include "../include/proxy.hpp"
+
+namespace ipc
+{
+#ifdef __linux__
+    inline socket_relay::socket_relay()
+    {
+        if (pipe2(m_pipe, O_NONBLOCK | O_CLOEXEC) != 0)
+            throw socket_api_failed_exception(errno, __FUNCTION_NAME__);
+    }
+
+    inline socket_relay::~socket_relay()
+    {
+        ::close(m_pipe[0]);
+        ::close(m_pipe[1]);
+    }
+
+    inline void socket_relay::discard() noexcept
+    {
+        char buffer[4096];
+        while (::read(m_pipe[0], buffer, sizeof(buffer)) > 0);
+    }
+
+    template <typename Predicate>
+    inline bool socket_relay::forward(socket_t from, socket_t to, const Predicate& predicate)
+    {
+        const ssize_t received = splice(from, nullptr, m_pipe[1], nullptr, chunk_size, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (received == 0)
+            return false;
+
+        if (received < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return true;
+
+            throw socket_read_exception(errno, __FUNCTION_NAME__);
+        }
+
+        try
+        {
+            for (ssize_t left = received; left != 0;)
+            {
+                const ssize_t sent = splice(m_pipe[0], nullptr, to, nullptr, left, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                if (sent >= 0)
+                    left -= sent;
+                else if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    throw socket_write_exception(errno, __FUNCTION_NAME__);
+                else if (!wait_for<false>(to, predicate))
+                    throw socket_write_exception(get_socket_error(), __FUNCTION_NAME__);
+            }
+        }
+        catch (...)
+        {
+            discard(); // unsent data must not be forwarded to the next connection
+            throw;
+        }
+
+        return true;
+    }
+#else
+    inline socket_relay::socket_relay() : m_buffer(chunk_size) {}
+    inline socket_relay::~socket_relay() {}
+    inline void socket_relay::discard() noexcept {}
+
+    template <typename Predicate>
+    inline bool socket_relay::forward(socket_t from, socket_t to, const Predicate& predicate)
+    {
+        const int received = recv(from, m_buffer.data(), (int)m_buffer.size(), 0);
+        if (received == 0)
+            return false;
+
+        if (received < 0)
+        {
+            const int err = get_socket_error();
+    #ifdef _WIN32
+            if (err == WSAEWOULDBLOCK)
+    #else
+            if (err == EAGAIN || err == EWOULDBLOCK)
+    #endif
+                return true;
+
+            throw socket_read_exception(err, __FUNCTION_NAME__);
+        }
+
+    #ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+    #else
+        const int flags = 0;
+    #endif // MSG_NOSIGNAL
+        for (int offset = 0; offset < received;)
+        {
+            const int sent = send(to, m_buffer.data() + offset, received - offset, flags);
+            if (sent >= 0)
+            {
+                offset += sent;
+                continue;
+            }
+
+            const int err = get_socket_error();
+    #ifdef _WIN32
+            if (err != WSAEWOULDBLOCK)
+    #else
+            if (err != EAGAIN && err != EWOULDBLOCK)
+    #endif
+                throw socket_write_exception(err, __FUNCTION_NAME__);
+
+            if (!wait_for<false>(to, predicate))
+                throw socket_write_exception(get_socket_error(), __FUNCTION_NAME__);
+        }
+
+        return true;
+    }
+#endif // __linux__
+
+    template <typename Server_socket> template <typename Router, typename Predicate>
+    inline void rpc_proxy<Server_socket>::run(const Router& router, const Predicate& predicate, unsigned int threads_count)
+    {
+        std::vector<std::thread> workers;
+        std::generate_n(std::back_inserter(workers), std::max(threads_count, 1u), [this, &router, &predicate]
+            { 
+                return std::thread(&rpc_proxy::thread_proc<Router, Predicate>, this, &router, &predicate);
+            });
+
+        router.ready();
+
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    template <typename Server_socket> template <typename Router, typename Predicate>
+    inline void rpc_proxy<Server_socket>::thread_proc(const Router* router, const Predicate* predicate)
+    {
+        in_message request(message::initial_read_size);
+        socket_relay relay;
+        while ((*predicate)())
+        {
+            try
+            {
+                auto client = m_server_socket.accept(*predicate);
+                try
+                {
+                    client.read_message(request, *predicate);
+                }
+                catch (const connection_closed_exception&)
+                {
+                    continue; // connection has been closed without request
+                }
+
+                uint32_t function = 0;
+                request >> function; // the only deserialized field
+
+                auto& balancer = router->route(function);
+                auto lease = balancer.acquire();
+                bool backend_failed = true; // connection and request forwarding failures are backend ones
+                try
+                {
+                    auto backend = make_client_socket(lease.get_address(), std::remove_reference_t<decltype(balancer)>::connect_attempts);
+                    backend.write_message(request.get_frame().data(), *predicate);
+                    backend_failed = false;
+                    relay_connection(client, backend, relay, *predicate, backend_failed);
+                    lease.complete(true);
+                }
+                catch (const system_error&)
+                {
+                    if (backend_failed)
+                        lease.complete(false); // client side failures and timeouts release lease without result
+                    throw;
+                }
+            }
+            catch (const user_stop_request_exception&) {} // proxy is stopping
+            catch (...)
+            {
+                router->report_error(std::current_exception());
+            }
+        }
+    }
+
+    template <typename Server_socket> template <typename Predicate>
+    inline void rpc_proxy<Server_socket>::relay_connection(point_to_point_socket& client, point_to_point_socket& backend, socket_relay& relay, const Predicate& predicate, bool& backend_failed)
+    {
+        point_to_point_socket* const sources[] = { &client, &backend };
+        bool open[] = { true, true }; // directions are closed independently (half closed connections are relayed)
+        while (open[0] || open[1])
+        {
+            int index = -1;
+            const auto timeout = std::chrono::duration_cast<std::chrono::microseconds>(m_idle_timeout);
+            if (open[0] && open[1])
+                index = wait_for_any({ client.get_handle(), backend.get_handle() }, timeout, predicate);
+            else if (open[0])
+                index = wait_for_any({ client.get_handle() }, timeout, predicate);
+            else if (wait_for_any({ backend.get_handle() }, timeout, predicate) == 0)
+                index = 1;
+
+            if (index < 0)
+                throw socket_read_exception(std::make_error_code(std::errc::timed_out).value(), __FUNCTION_NAME__);
+
+            point_to_point_socket& destination = *sources[1 - index];
+            bool forwarded = false;
+            try
+            {
+                forwarded = relay.forward(sources[index]->get_handle(), destination.get_handle(), predicate);
+            }
+            catch (const socket_read_exception&)
+            {
+                backend_failed = (index == 1);
+                throw;
+            }
+            catch (const socket_write_exception&)
+            {
+                backend_failed = (index == 0);
+                throw;
+            }
+
+            if (!forwarded)
+            {
+                open[index] = false;
+                destination.shutdown(); // end of stream is forwarded too
+            }
+        }
+    }
+}
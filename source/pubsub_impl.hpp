@@ -0,0 +1,297 @@
+/**
+ * Lightweight inter process communication library
+ * Copyright (C) 2020 Pavel Kovalenko
+ *
+ * This Source Code Form is subject to the terms of the Mozilla
+ * Public License, v. 2.0. If a copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+/*
+    Inline methods (pubsub.h) implementations. It shouldn't be used directly.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+
+#include "../include/pubsub.hpp"
+
+namespace ipc
+{
+    template <typename Predicate>
+    inline void message_stream::read_message(point_to_point_socket& socket, in_message& message, const Predicate& predicate)
+    {
+        while (true)
+        {
+            size_t size = (size_t)(-1);
+            if (m_end - m_begin >= sizeof(__MSG_LENGTH_TYPE__))
+            {
+                __MSG_LENGTH_TYPE__ length = 0;
+                memcpy(&length, m_buffer.data() + m_begin, sizeof(length));
+                check_status<bad_message_exception>(length >= sizeof(__MSG_LENGTH_TYPE__), std::string(__FUNCTION_NAME__) + ": bad message length");
+                check_status<message_overflow_exception>(length <= msg_max_length, std::string(__FUNCTION_NAME__) + ": message is too long");
+
+                size = length;
+                if (m_end - m_begin >= size)
+                {
+                    message.assign_frame(m_buffer.data() + m_begin);
+                    m_begin += size;
+                    return;
+                }
+            }
+
+            if (m_begin != 0) // unreturned data is moved to buffer start
+            {
+                memmove(m_buffer.data(), m_buffer.data() + m_begin, m_end - m_begin);
+                m_end -= m_begin;
+                m_begin = 0;
+            }
+
+            if (size != (size_t)(-1) && m_buffer.size() < size)
+                m_buffer.resize(size);
+
+            if (!wait_for<true>(socket.get_handle(), predicate))
+                throw socket_read_exception(get_socket_error(), __FUNCTION_NAME__);
+
+            const int result = recv(socket.get_handle(), m_buffer.data() + m_end, (int)(m_buffer.size() - m_end), 0);
+            if (result == 0)
+                throw connection_closed_exception(0, std::string(__FUNCTION_NAME__) + ": connection has been closed by peer");
+
+            if (result < 0)
+            {
+                const int err = get_socket_error();
+    #ifdef _WIN32
+                if (err == WSAEWOULDBLOCK)
+    #else
+                if (err == EAGAIN || err == EWOULDBLOCK)
+    #endif
+                    continue;
+
+                throw socket_read_exception(err, __FUNCTION_NAME__);
+            }
+
+            m_end += result;
+        }
+    }
+
+    template <typename Server_socket>
+    inline bool pubsub_server<Server_socket>::subscriber::push(const publication_ptr& publication)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (m_queue.size() >= m_capacity)
+            {
+                ++m_dropped;
+                return false;
+            }
+
+            m_queue.push_back(publication);
+        }
+
+        m_wake.notify_one();
+        return true;
+    }
+
+    template <typename Server_socket>
+    inline uint64_t pubsub_server<Server_socket>::subscriber::take(std::vector<publication_ptr>& batch, clock::duration timeout)
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_wake.wait_for(lock, timeout, [this] { return !m_queue.empty() || m_dropped != 0; });
+        batch.swap(m_queue);
+
+        const uint64_t dropped = m_dropped;
+        m_dropped = 0;
+        return dropped;
+    }
+
+    template <typename Server_socket> template <typename... Args>
+    inline size_t pubsub_server<Server_socket>::publish(std::string_view topic, const Args&... args)
+    {
+        auto publication = std::make_shared<out_message>();
+        *publication << (uint32_t)pubsub_message::publication << topic;
+        (*publication << ... << args);
+
+        size_t count = 0;
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_topics.find(topic);
+        if (it == m_topics.end())
+            return 0;
+
+        for (subscriber* s : it->second)
+        {
+            if (s->push(publication))
+                ++count;
+            else
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        return count;
+    }
+
+    template <typename Server_socket>
+    inline size_t pubsub_server<Server_socket>::get_subscribers_count(std::string_view topic) const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_topics.find(topic);
+        return it != m_topics.end() ? it->second.size() : 0;
+    }
+
+    template <typename Server_socket>
+    inline void pubsub_server<Server_socket>::subscribe(subscriber& s, std::string_view topic)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_topics.find(topic);
+        if (it == m_topics.end())
+            it = m_topics.emplace(std::string(topic), std::vector<subscriber*>()).first;
+
+        if (std::find(it->second.begin(), it->second.end(), &s) == it->second.end())
+            it->second.push_back(&s);
+    }
+
+    template <typename Server_socket>
+    inline void pubsub_server<Server_socket>::unsubscribe(subscriber& s, std::string_view topic)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_topics.find(topic);
+        if (it == m_topics.end())
+            return;
+
+        it->second.erase(std::remove(it->second.begin(), it->second.end(), &s), it->second.end());
+        if (it->second.empty())
+            m_topics.erase(it);
+    }
+
+    template <typename Server_socket> template <typename Handler, typename Predicate>
+    inline void pubsub_server<Server_socket>::run(const Handler& handler, const Predicate& predicate, unsigned int max_subscribers)
+    {
+        std::vector<std::thread> workers;
+        std::generate_n(std::back_inserter(workers), std::max(max_subscribers, 1u), [this, &handler, &predicate]
+            {
+                return std::thread(&pubsub_server::thread_proc<Handler, Predicate>, this, &handler, &predicate);
+            });
+
+        handler.ready();
+
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    template <typename Server_socket> template <typename Handler, typename Predicate>
+    inline void pubsub_server<Server_socket>::thread_proc(const Handler* handler, const Predicate* predicate)
+    {
+        while ((*predicate)())
+        {
+            try
+            {
+                auto client = m_server_socket.accept(*predicate);
+                subscriber s(m_queue_capacity);
+                std::vector<std::string> topics;
+                try
+                {
+                    serve(client, s, topics, *predicate);
+                }
+                catch (...)
+                {
+                    for (const auto& topic : topics)
+                        unsubscribe(s, topic);
+
+                    throw;
+                }
+            }
+            catch (const connection_closed_exception&) {} // subscriber has disconnected
+            catch (const user_stop_request_exception&) {} // service is stopping
+            catch (...)
+            {
+                handler->report_error(std::current_exception());
+            }
+        }
+    }
+
+    template <typename Server_socket> template <typename Predicate>
+    inline void pubsub_server<Server_socket>::serve(point_to_point_socket& client, subscriber& s, std::vector<std::string>& topics, const Predicate& predicate)
+    {
+        std::vector<publication_ptr> batch;
+        out_message notice;
+        in_message command(message::initial_read_size);
+        message_stream commands(256); // commands are short
+        while (true)
+        {
+            const uint64_t dropped = s.take(batch, command_poll_interval);
+            if (dropped != 0)
+            {
+                notice.clear();
+                notice << (uint32_t)pubsub_message::dropped << dropped;
+                client.write_message(notice, predicate);
+            }
+
+            for (const auto& publication : batch)
+                client.write_message(publication->get_data().data(), predicate);
+
+            batch.clear();
+
+            if (commands.get_buffered_size() == 0 && wait_for_any({ client.get_handle() }, std::chrono::microseconds::zero(), predicate) != 0)
+                continue;
+
+            commands.read_message(client, command, predicate);
+
+            uint32_t kind = 0;
+            std::string topic;
+            command >> kind >> topic;
+            auto it = std::find(topics.begin(), topics.end(), topic);
+            if (kind == (uint32_t)pubsub_message::subscribe)
+            {
+                if (it == topics.end())
+                {
+                    subscribe(s, topic);
+                    topics.push_back(std::move(topic));
+                }
+            }
+            else if (kind == (uint32_t)pubsub_message::unsubscribe)
+            {
+                if (it != topics.end())
+                {
+                    unsubscribe(s, topic);
+                    topics.erase(it);
+                }
+            }
+            else
+                throw bad_message_exception(std::string(__FUNCTION_NAME__) + ": unknown subscription command");
+        }
+    }
+
+    template <typename Client_socket> template <typename Predicate>
+    inline void pubsub_client<Client_socket>::send_command(pubsub_message command, std::string_view topic, const Predicate& predicate)
+    {
+        m_command.clear();
+        m_command << (uint32_t)command << topic;
+        m_socket.write_message(m_command, predicate);
+    }
+
+    template <typename Client_socket> template <typename Predicate>
+    inline std::string_view pubsub_client<Client_socket>::receive(in_message& message, const Predicate& predicate)
+    {
+        while (true)
+        {
+            m_stream.read_message(m_socket, message, predicate);
+
+            uint32_t kind = 0;
+            message >> kind;
+            if (kind == (uint32_t)pubsub_message::publication)
+            {
+                std::string_view topic;
+                message >> topic;
+                return topic;
+            }
+
+            if (kind != (uint32_t)pubsub_message::dropped)
+                throw bad_message_exception(std::string(__FUNCTION_NAME__) + ": unknown publication kind");
+
+            uint64_t count = 0;
+            message >> count;
+            m_dropped += count;
+        }
+    }
+}
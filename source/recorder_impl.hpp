@@ -0,0 +1,303 @@
+/**
+ * Lightweight inter process communication library
+ * Copyright (C) 2020 Pavel Kovalenko
+ *
+ * This Source Code Form is subject to the terms of the Mozilla
+ * Public License, v. 2.0. If a copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+/*
+    Inline methods (recorder.h) implementations. It shouldn't be used directly.
+*/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iterator>
+#include <new>
+
+#ifdef _WIN32
+#   include <io.h>
+#else
+#   include <signal.h>
+#   include <unistd.h>
+#endif // _WIN32
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#   ifdef _MSC_VER
+#       include <intrin.h>
+#   else
+#       include <x86intrin.h>
+#   endif // _MSC_VER
+#   define __IPC_FLIGHT_TSC__ 1
+#endif
+
+#include "../include/recorder.hpp"
+
+namespace ipc
+{
+    inline uint64_t read_flight_clock() noexcept
+    {
+#ifdef __IPC_FLIGHT_TSC__
+        return __rdtsc();
+#else
+        return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif // __IPC_FLIGHT_TSC__
+    }
+
+    inline int64_t read_flight_time() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    struct flight_clock_base
+    {
+        uint64_t ticks;
+        int64_t time;
+    };
+
+    // clock ticks are converted to nanoseconds at dump time, rate is measured between the first ring creation and dump
+    inline const flight_clock_base& get_flight_clock_base() noexcept
+    {
+        static const flight_clock_base base{ read_flight_clock(), read_flight_time() };
+        return base;
+    }
+
+    /*
+        Single writer ring of events. Event is stored as two atomic words (timestamp, type and value), written counter is published after the event,
+        so readers of other threads (or signal handlers) can copy events without locks and skip events that have been overwritten during copying.
+        Rings are never freed (they can be dumped at any moment), ring of finished thread is reused by the next new thread, which starts it from empty state.
+    */
+    class flight_ring
+    {
+    public:
+        static constexpr size_t capacity = 2048; // power of two
+
+        void push(flight_event e, uint32_t value) noexcept
+        {
+            const uint64_t written = m_written.load(std::memory_order_relaxed);
+            auto& slot = m_slots[written & (capacity - 1)];
+            std::atomic_thread_fence(std::memory_order_release); // counter is visible before the slot is overwritten
+            slot[0].store(read_flight_clock(), std::memory_order_relaxed);
+            slot[1].store(((uint64_t)e << 32) | value, std::memory_order_relaxed);
+            m_written.store(written + 1, std::memory_order_release);
+        }
+
+        // events of previous owner are hidden (written counter is kept monotonic, so readers never mistake old slots for new events)
+        void reset() noexcept
+        {
+            m_first.store(m_written.load(std::memory_order_relaxed), std::memory_order_release);
+        }
+
+        template <typename Callable>
+        void for_each(const Callable& callable) const noexcept
+        {
+            const uint64_t written = m_written.load(std::memory_order_acquire);
+            const uint64_t first = std::max(m_first.load(std::memory_order_acquire), (written >= capacity) ? written - capacity + 1 : 0);
+            for (uint64_t i = first; i < written; ++i) // the oldest slot is the next one to be overwritten
+            {
+                const auto& slot = m_slots[i & (capacity - 1)];
+                const uint64_t ticks = slot[0].load(std::memory_order_relaxed);
+                const uint64_t data = slot[1].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (m_written.load(std::memory_order_relaxed) >= i + capacity)
+                    continue; // slot has been overwritten during copying
+
+                callable(ticks, (flight_event)(data >> 32), (uint32_t)data);
+            }
+        }
+
+        std::atomic<bool> owned = true; ///< ring is used by running thread
+        std::atomic<uint64_t> thread = 0; ///< thread ordinal number
+        flight_ring* next = nullptr; ///< next registered ring
+
+    protected:
+        std::array<std::array<std::atomic<uint64_t>, 2>, capacity> m_slots = {};
+        std::atomic<uint64_t> m_written = 0;
+        std::atomic<uint64_t> m_first = 0; ///< the first event of current owner
+    };
+
+    inline std::atomic<flight_ring*>& get_flight_rings() noexcept
+    {
+        static std::atomic<flight_ring*> head = nullptr;
+        return head;
+    }
+
+    inline flight_ring* acquire_flight_ring() noexcept
+    {
+        static std::atomic<uint64_t> threads_count = 0;
+
+        get_flight_clock_base();
+        const uint64_t thread = ++threads_count;
+        auto& head = get_flight_rings();
+        for (flight_ring* ring = head.load(std::memory_order_acquire); ring != nullptr; ring = ring->next)
+        {
+            bool owned = false;
+            if (ring->owned.compare_exchange_strong(owned, true, std::memory_order_acquire))
+            {
+                ring->reset();
+                ring->thread.store(thread, std::memory_order_relaxed);
+                return ring;
+            }
+        }
+
+        flight_ring* ring = new (std::nothrow) flight_ring;
+        if (ring == nullptr)
+            return nullptr; // events of this thread are not recorded
+
+        ring->thread.store(thread, std::memory_order_relaxed);
+        ring->next = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(ring->next, ring, std::memory_order_release, std::memory_order_relaxed));
+        return ring;
+    }
+
+    struct flight_ring_owner
+    {
+        flight_ring* ring;
+
+        ~flight_ring_owner()
+        {
+            if (ring != nullptr)
+                ring->owned.store(false, std::memory_order_release);
+        }
+    };
+
+    inline void record_flight_event(flight_event e, uint32_t value) noexcept
+    {
+        thread_local flight_ring_owner owner{ acquire_flight_ring() };
+        if (owner.ring != nullptr)
+            owner.ring->push(e, value);
+    }
+
+    /*
+        Records call start on construction and call end (or error if scope is left by exception) on destruction.
+    */
+    class flight_call_scope
+    {
+    public:
+        explicit flight_call_scope(uint32_t function) noexcept : m_function(function), m_exceptions(std::uncaught_exceptions())
+        {
+            record_flight_event(flight_event::call_start, m_function);
+        }
+
+        ~flight_call_scope()
+        {
+            record_flight_event(std::uncaught_exceptions() > m_exceptions ? flight_event::error : flight_event::call_end, m_function);
+        }
+
+        flight_call_scope(const flight_call_scope&) = delete;
+        flight_call_scope& operator = (const flight_call_scope&) = delete;
+
+    protected:
+        uint32_t m_function;
+        int m_exceptions;
+    };
+
+    /*
+        Async signal safe text output (no allocations, no locks, no locale).
+    */
+    class flight_line
+    {
+    public:
+        flight_line& operator << (const char* text) noexcept
+        {
+            while (*text != '\0' && m_size < m_data.size())
+                m_data[m_size++] = *text++;
+
+            return *this;
+        }
+
+        flight_line& operator << (uint64_t value) noexcept
+        {
+            std::array<char, 20> digits;
+            size_t count = 0;
+            do
+            {
+                digits[count++] = (char)('0' + value % 10);
+                value /= 10;
+            } while (value != 0);
+
+            while (count != 0 && m_size < m_data.size())
+                m_data[m_size++] = digits[--count];
+
+            return *this;
+        }
+
+        void flush(int fd) noexcept
+        {
+            for (size_t offset = 0; offset < m_size;)
+            {
+#ifdef _WIN32
+                const int result = _write(fd, m_data.data() + offset, (unsigned int)(m_size - offset));
+#else
+                const ssize_t result = ::write(fd, m_data.data() + offset, m_size - offset);
+#endif // _WIN32
+                if (result <= 0)
+                    break;
+
+                offset += (size_t)result;
+            }
+
+            m_size = 0;
+        }
+
+    protected:
+        std::array<char, 128> m_data;
+        size_t m_size = 0;
+    };
+
+    inline void dump_flight_recorder(int fd) noexcept
+    {
+        static const char* const names[] = { "accept", "read_start", "read_end", "dispatch_start", "dispatch_end", "write", "error", "call_start", "call_end" };
+
+        flight_ring* head = get_flight_rings().load(std::memory_order_acquire);
+        if (head == nullptr)
+            return;
+
+        const auto& base = get_flight_clock_base();
+        const uint64_t now_ticks = read_flight_clock();
+        const int64_t now_time = read_flight_time();
+        const double ns_per_tick = (now_ticks > base.ticks && now_time > base.time) ? (double)(now_time - base.time) / (double)(now_ticks - base.ticks) : 1.0;
+
+        flight_line line;
+        for (const flight_ring* ring = head; ring != nullptr; ring = ring->next)
+        {
+            const uint64_t thread = ring->thread.load(std::memory_order_relaxed);
+            ring->for_each([&](uint64_t ticks, flight_event e, uint32_t value)
+                {
+                    const uint64_t age = (now_ticks > ticks) ? (uint64_t)((double)(now_ticks - ticks) * ns_per_tick) : 0;
+                    const size_t index = (size_t)e;
+                    line << "thread=" << thread << " age=" << age << "ns event=" << (index < std::size(names) ? names[index] : "unknown") << " value=" << (uint64_t)value << "\n";
+                    line.flush(fd);
+                });
+        }
+    }
+
+#ifndef _WIN32
+    inline std::atomic<int>& get_flight_recorder_fd() noexcept
+    {
+        static std::atomic<int> fd = 2;
+        return fd;
+    }
+
+    inline void flight_recorder_signal_handler(int) noexcept
+    {
+        dump_flight_recorder(get_flight_recorder_fd().load(std::memory_order_relaxed));
+    }
+
+    inline bool install_flight_recorder_handler(int signum, int fd) noexcept
+    {
+        get_flight_recorder_fd().store(fd, std::memory_order_relaxed);
+
+        struct sigaction action = {};
+        action.sa_handler = flight_recorder_signal_handler;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        return sigaction(signum, &action, nullptr) == 0;
+    }
+#endif // _WIN32
+}
@@ -13,7 +13,16 @@
 #pragma once
 
 #include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <exception>
+#include <optional>
+#include <system_error>
+
+#ifndef _WIN32
+#   include <signal.h>
+#   include <sys/wait.h>
+#endif // _WIN32
 
 #include "../include/rpc.hpp"
 
@@ -22,39 +31,315 @@ namespace ipc
     template <typename Server_socket> template <typename Dispatcher, typename Predicate>
     inline void rpc_server<Server_socket>::run(const Dispatcher& dispatcher, const Predicate& predicate)
     {
+#if defined(__AFUNIX_H__) && !defined(_WIN32)
+        std::thread handoff;
+        if (!m_handoff_path.empty())
+            handoff = std::thread(&rpc_server::handoff_proc<Dispatcher, Predicate>, this, &dispatcher, &predicate);
+#endif // __AFUNIX_H__ && !_WIN32
+
+        run_threads(dispatcher, predicate, std::thread::hardware_concurrency(), true);
+
+#if defined(__AFUNIX_H__) && !defined(_WIN32)
+        if (handoff.joinable())
+            handoff.join();
+#endif // __AFUNIX_H__ && !_WIN32
+    }
+
+#if defined(__AFUNIX_H__) && !defined(_WIN32)
+    template <typename Server_socket> template <typename Dispatcher, typename Predicate>
+    inline void rpc_server<Server_socket>::handoff_proc(const Dispatcher* d, const Predicate* predicate)
+    {
+        auto accepting = [this, predicate] { return !m_draining.load(std::memory_order_relaxed) && (*predicate)(); };
+        try
+        {
+            unix_server_socket control(m_handoff_path);
+            auto p2p_socket = control.accept(accepting);
+            control.close(); // new server binds the same control path after receiving listening socket
+
+            p2p_socket.send_handle(m_server_socket.get_handle());
+            m_server_socket.hand_off();
+            m_draining.store(true, std::memory_order_relaxed);
+        }
+        catch (const user_stop_request_exception&) {} // server is stopping without handoff
+        catch (...)
+        {
+            d->report_error(std::current_exception());
+        }
+    }
+#endif // __AFUNIX_H__ && !_WIN32
+
+    template <typename Server_socket> template <typename Dispatcher, typename Predicate>
+    inline void rpc_server<Server_socket>::run_threads(const Dispatcher& dispatcher, const Predicate& predicate, unsigned int threads_count, bool notify)
+    {
+        if (m_metrics)
+            m_metrics->add_workers(std::max(threads_count, 1u));
+
         std::vector<std::thread> workers;
-        std::generate_n(std::back_inserter(workers), std::thread::hardware_concurrency(), [this, &dispatcher, &predicate]
+        std::generate_n(std::back_inserter(workers), std::max(threads_count, 1u), [this, &dispatcher, &predicate]
             { 
                 return std::thread(&rpc_server::thread_proc<Dispatcher, Predicate>, this, &dispatcher, &predicate);
             });
     
-        dispatcher.ready();
+        if (notify)
+            dispatcher.ready();
 
         for (auto& worker : workers)
             worker.join();
+
+        if (m_metrics)
+            m_metrics->add_workers(-(int64_t)workers.size());
     }
+
+#ifndef _WIN32
+    template <typename Server_socket> template <typename Dispatcher, typename Predicate>
+    inline void rpc_server<Server_socket>::run_prefork(const Dispatcher& dispatcher, const Predicate& predicate, unsigned int processes_count, unsigned int threads_count, int stop_signal)
+    {
+        typedef std::chrono::steady_clock clock;
+
+        if (m_slow_log)
+            throw slow_call_log_exception(EINVAL, std::string(__FUNCTION_NAME__) + ": slow call log writer can't be shared by forked workers");
+
+        std::vector<pid_t> workers(std::max(processes_count, 1u), -1);
+        std::vector<clock::time_point> started(workers.size());
+        auto spawn = [&](size_t index)
+        {
+            const pid_t pid = fork();
+            if (pid == 0)
+            {
+                int code = 0;
+                try
+                {
+                    run_threads(dispatcher, predicate, threads_count, false);
+                }
+                catch (...)
+                {
+                    code = 1;
+                }
+
+                _exit(code); // worker must not return to supervisor code
+            }
+
+            if (pid < 0)
+                dispatcher.report_error(std::make_exception_ptr(std::system_error(errno, std::generic_category(), std::string(__FUNCTION_NAME__) + ": fork failed")));
+
+            workers[index] = pid;
+            started[index] = clock::now();
+        };
+
+        for (size_t i = 0; i < workers.size(); ++i)
+            spawn(i);
+
+        dispatcher.ready();
+
+        while (predicate())
+        {
+            bool exited = false;
+            for (pid_t& pid : workers) // only own workers are reaped, other children of the process are left to their owners
+            {
+                int status = 0;
+                if (pid > 0 && waitpid(pid, &status, WNOHANG) == pid)
+                {
+                    pid = -1;
+                    exited = true;
+                }
+            }
+
+            for (size_t i = 0; i < workers.size(); ++i)
+                if (workers[i] < 0 && clock::now() - started[i] >= std::chrono::seconds(1) && predicate()) // respawn throttling prevents fork loop of crashing workers
+                    spawn(i);
+
+            if (!exited)
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+
+        for (pid_t pid : workers)
+            if (pid > 0)
+                kill(pid, stop_signal);
+
+        for (pid_t pid : workers)
+            if (pid > 0)
+                waitpid(pid, nullptr, 0);
+    }
+#endif // _WIN32
     
+    template <typename Dispatcher, typename = void>
+    struct has_response_ttl : std::false_type {};
+
+    template <typename Dispatcher>
+    struct has_response_ttl<Dispatcher, std::void_t<decltype(std::declval<const Dispatcher&>().response_ttl(uint32_t()))>> : std::true_type {};
+
+    template <typename Dispatcher, typename = void>
+    struct has_idempotence_check : std::false_type {};
+
+    template <typename Dispatcher>
+    struct has_idempotence_check<Dispatcher, std::void_t<decltype(std::declval<const Dispatcher&>().is_idempotent(uint32_t()))>> : std::true_type {};
+
     template <typename Server_socket> template <typename Dispatcher, typename Predicate>
     inline void rpc_server<Server_socket>::thread_proc(const Dispatcher* d, const Predicate* predicate)
     {
-        in_message in_msg;
+        in_message in_msg(message::initial_read_size);
         out_message out_msg;
+        std::string slow_payload; // request payload is sampled before dispatching (callbacks reuse message)
+        std::optional<request_arena> arena;
+        if (m_arena_size != 0)
+            arena.emplace(m_arena_size);
     
-        while ((*predicate)())
+        auto accepting = [this, predicate] { return !m_draining.load(std::memory_order_relaxed) && (*predicate)(); };
+        while (accepting())
         {
             try
             {
-                auto p2p_socket = m_server_socket.accept(*predicate);
-                p2p_socket.read_message(in_msg, *predicate);
+                auto p2p_socket = m_server_socket.accept(accepting);
+                std::optional<request_arena::scope> arena_scope;
+                if (arena)
+                    arena_scope.emplace(*arena);
+
+                server_metrics::connection_scope connection_metrics(m_metrics.get());
+                record_flight_event(flight_event::accept);
+#ifndef _WIN32
+                if (m_capture != nullptr)
+                    p2p_socket.set_capture(m_capture, m_capture->make_connection_id());
+#endif // _WIN32
+#if __MSG_USE_TRACING__
+                const int64_t read_start = get_trace_time();
+#endif // __MSG_USE_TRACING__
+                const bool timed = (m_slow_log != nullptr || m_metrics);
+                std::chrono::steady_clock::time_point phase_read_start, phase_read_end, phase_dispatch_end;
+                if (timed)
+                    phase_read_start = std::chrono::steady_clock::now();
+
+                record_flight_event(flight_event::read_start);
+                try
+                {
+                    p2p_socket.read_message(in_msg, *predicate);
+                }
+                catch (const connection_closed_exception&)
+                {
+                    continue; // connection without request (health check or circuit breaker probe)
+                }
     
                 uint32_t function = 0;
                 in_msg >> function;
-                d->invoke(function, in_msg, out_msg, p2p_socket);
-                p2p_socket.write_message(out_msg, *predicate);
+                record_flight_event(flight_event::read_end, function);
+                size_t slow_payload_size = 0;
+                if (m_slow_log != nullptr)
+                {
+                    const auto payload = in_msg.get_payload();
+                    slow_payload_size = payload.size();
+                    slow_payload.assign(payload.substr(0, m_slow_log->get_dump_size()));
+                }
+
+                if (timed)
+                    phase_read_end = std::chrono::steady_clock::now();
+#if __MSG_USE_TRACING__
+                span_scope trace_span(span_kind::server, function, in_msg.get_trace_context(), read_start);
+                trace_span.mark_read();
+#endif // __MSG_USE_TRACING__
+
+                response_cache::clock::duration ttl{};
+                if constexpr (has_response_ttl<Dispatcher>::value)
+                {
+                    if (m_cache)
+                        ttl = d->response_ttl(function);
+                }
+
+                bool coalesce = (ttl > ttl.zero());
+                if constexpr (has_idempotence_check<Dispatcher>::value)
+                    coalesce = coalesce || d->is_idempotent(function);
+
+                const bool metrics_request = (m_metrics && function == function_invoker_base::metrics_id);
+
+                record_flight_event(flight_event::dispatch_start, function);
+                if (coalesce && !metrics_request)
+                {
+                    auto frame = (ttl > ttl.zero()) ? m_cache->find(in_msg.get_payload()) : nullptr;
+                    if (!frame)
+                    {
+                        std::string key(in_msg.get_payload());
+                        frame = m_flights.run(key, [&]
+                            {
+                                d->invoke(function, in_msg, out_msg, p2p_socket);
+                                const auto& data = out_msg.get_data();
+                                auto result = std::make_shared<const std::vector<char>>(data.begin(), data.end());
+                                if (ttl > ttl.zero())
+                                    m_cache->insert(std::move(key), result, ttl);
+
+                                return result;
+                            });
+                    }
+
+                    record_flight_event(flight_event::dispatch_end, function);
+                    if (timed)
+                        phase_dispatch_end = std::chrono::steady_clock::now();
+#if __MSG_USE_TRACING__
+                    trace_span.mark_dispatched();
+#endif // __MSG_USE_TRACING__
+                    p2p_socket.write_message(frame->data(), *predicate);
+                }
+                else
+                {
+                    if (metrics_request)
+                    {
+                        out_msg.clear();
+                        out_msg << function_invoker_base::done_tag;
+                        m_metrics->get_snapshot(m_cache ? m_cache->get_memory_usage() : 0).serialize(out_msg);
+                    }
+                    else
+                        d->invoke(function, in_msg, out_msg, p2p_socket);
+
+                    record_flight_event(flight_event::dispatch_end, function);
+                    if (timed)
+                        phase_dispatch_end = std::chrono::steady_clock::now();
+#if __MSG_USE_TRACING__
+                    trace_span.mark_dispatched();
+#endif // __MSG_USE_TRACING__
+                    p2p_socket.write_message(out_msg, *predicate);
+                }
+                record_flight_event(flight_event::write, function);
+#if __MSG_USE_TRACING__
+                trace_span.mark_written();
+#endif // __MSG_USE_TRACING__
+                if (timed)
+                {
+                    const auto written = std::chrono::steady_clock::now();
+                    if (m_metrics)
+                        m_metrics->record_call(function, written - phase_read_start);
+
+                    if (m_slow_log != nullptr && written - phase_read_start >= m_slow_log->get_threshold())
+                    {
+                        auto nanoseconds = [](std::chrono::steady_clock::duration d) { return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(d).count(); };
+
+                        slow_call call;
+                        call.timestamp = get_trace_time();
+                        call.function = function;
+                        call.read = nanoseconds(phase_read_end - phase_read_start);
+                        call.dispatch = nanoseconds(phase_dispatch_end - phase_read_end);
+                        call.write = nanoseconds(written - phase_dispatch_end);
+                        call.payload_size = slow_payload_size;
+                        call.payload = slow_payload;
+                        m_slow_log->submit(std::move(call));
+                    }
+                }
+
                 p2p_socket.wait_for_shutdown(*predicate);
             }
+            catch (const user_stop_request_exception&)
+            {
+                if (!m_draining.load(std::memory_order_relaxed))
+                {
+                    record_flight_event(flight_event::error);
+                    if (m_metrics)
+                        m_metrics->record_error();
+
+                    d->report_error(std::current_exception());
+                }
+            }
             catch (...)
             {
+                record_flight_event(flight_event::error);
+                if (m_metrics)
+                    m_metrics->record_error();
+
                 std::exception_ptr p = std::current_exception();
                 d->report_error(p);
             }
@@ -64,7 +349,12 @@ namespace ipc
     template <typename Tuple, size_t... I>
     static inline void input_tuple([[maybe_unused]] in_message& msg, [[maybe_unused]] Tuple& t, std::index_sequence<I...>)
     {
-        if constexpr (sizeof...(I) != 0)
+        if constexpr (in_message::can_validate<std::tuple_element_t<I, Tuple>...>)
+        {
+            msg.validate<std::tuple_element_t<I, Tuple>...>(); // the whole request is checked by one pass
+            (msg.get_unchecked(std::get<I>(t)), ...);
+        }
+        else if constexpr (sizeof...(I) != 0)
             (msg >> ... >> std::get<I>(t));
     }
     
@@ -89,74 +379,322 @@ namespace ipc
         }
     }
 
-#ifdef __AFUNIX_H__
-    template <typename T>
-    static inline auto make_client_socket(const std::tuple<T>& tuple)
+    class message_cleaner
     {
-        return ipc::unix_client_socket(std::get<0>(tuple));
-    }
-#endif // __AFUNIX_H__
+        in_message& m_in_msg;
+        out_message& m_out_msg;
+    public:
+        message_cleaner(in_message& in_msg, out_message& out_msg) noexcept : m_in_msg(in_msg), m_out_msg(out_msg) {}
+        ~message_cleaner()
+        {
+            m_in_msg.clear();
+            m_out_msg.clear();
+        }
+    };
 
-    template <typename T1, typename T2>
-    static inline auto make_client_socket(const std::tuple<T1, T2>& tuple)
+    typedef std::vector<std::pair<uintptr_t, size_t>> readable_regions; ///< client memory regions that server may read during call
+
+    static inline void add_readable_region(readable_regions& regions, const readable_ptr& p)
     {
-        return ipc::tcp_client_socket(std::get<0>(tuple), std::get<1>(tuple));
+        regions.emplace_back((uintptr_t)p.get_pointer(), p.get_size());
     }
 
-    template <uint32_t Id, typename R, typename Tuple, typename Dispatcher, typename Predicate, typename... Args>
-    inline R service_invoker::call_by_address(const Tuple& address, Dispatcher& dispatcher, const Predicate& pred, const Args&... args)
+    template <typename T>
+    static inline void add_readable_region(readable_regions&, const T&) noexcept {}
+
+    template <typename T>
+    struct is_remote_pointer : std::bool_constant<std::is_base_of_v<message::remote_ptr<true>, T> || std::is_base_of_v<message::remote_ptr<false>, T>> {};
+
+    static inline void answer_remote_read(in_message& in_msg, out_message& out_msg, const readable_regions* regions)
     {
-        auto client_socket = make_client_socket(address);
-        
-        out_message request;
-        request << (uint32_t)Id;
-        if constexpr (sizeof...(args) != 0)
-            (request << ... << args);
+        uint32_t count = 0;
+        in_msg >> count;
+
+        const size_t max_size = std::min<size_t>(function_invoker_base::max_remote_read_size, out_msg.get_max_size() / 2);
+        std::vector<uint8_t> data;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            message::remote_ptr<true> p;
+            uint32_t size = 0;
+            in_msg >> p >> size;
+
+            const uintptr_t begin = (uintptr_t)p.get_pointer();
+            auto inside = [begin, size](const auto& region) { return begin >= region.first && size <= region.second && begin - region.first <= region.second - size; };
+            if (regions == nullptr || std::none_of(regions->begin(), regions->end(), inside))
+                throw bad_message_exception(std::string(__FUNCTION_NAME__) + ": remote read is out of readable regions");
 
-        in_message response;
+            if (size > max_size - data.size())
+                throw message_overflow_exception(std::string(__FUNCTION_NAME__) + ": remote read is too long");
+
+            data.insert(data.end(), (const uint8_t*)begin, (const uint8_t*)begin + size);
+        }
+
+        out_msg << std::make_pair((const uint8_t*)data.data(), data.size());
+    }
+
+    template <typename Dispatcher, typename Predicate>
+    static inline void exchange_by_channel(point_to_point_socket& client_socket, Dispatcher& dispatcher, const Predicate& pred, out_message& request, in_message& response, bool request_sent = false, 
+        const readable_regions* regions = nullptr)
+    {
         while (true)
         {
-            client_socket.write_message(request, pred);
+            if (!request_sent)
+                client_socket.write_message(request, pred);
+            request_sent = false;
             
             uint32_t callback_id = 0;
             client_socket.read_message(response, pred);
             response >> callback_id;
             request.clear();
+
+            if (callback_id == function_invoker_base::remote_read_tag)
+            {
+                answer_remote_read(response, request, regions);
+                continue;
+            }
     
             if (!dispatcher(callback_id, response, request))
+                return;
+        }
+    }
+
+    template <typename Tuple, typename Dispatcher, typename Predicate>
+    static inline void exchange_by_address(const Tuple& address, int connect_attempts, Dispatcher& dispatcher, const Predicate& pred, out_message& request, in_message& response, 
+        const readable_regions* regions = nullptr)
+    {
+        auto client_socket = make_client_socket(address, connect_attempts);
+        exchange_by_channel(client_socket, dispatcher, pred, request, response, false, regions);
+    }
+
+    template <typename Tuple>
+    static inline std::string make_address_key(const Tuple& address)
+    {
+        std::string key;
+        std::apply([&key](const auto&... parts)
             {
-                if constexpr (!std::is_same_v<void, R>)
+                auto append = [&key](const auto& part)
                 {
-                    R result{};
-                    response >> result;
+                    if constexpr (std::is_arithmetic_v<std::decay_t<decltype(part)>>)
+                        key.append(std::to_string(part));
+                    else
+                        key.append(std::string_view(part));
+                    key.push_back('\0');
+                };
+
+                (append(parts), ...);
+            }, address);
+
+        return key;
+    }
+
+    template <uint32_t Id, typename R, typename Tuple, typename Dispatcher, typename Predicate, typename... Args>
+    inline R service_invoker::call_by_address(const Tuple& address, Dispatcher& dispatcher, const Predicate& pred, const Args&... args)
+    {
+        return call_by_address_proc<Id, R>(address, client_socket::default_connect_attempts, dispatcher, pred, args...);
+    }
+
+    template <uint32_t Id, typename R, typename Tuple, typename Dispatcher, typename Predicate, typename... Args>
+    inline R service_invoker::call_by_address_proc(const Tuple& address, int connect_attempts, Dispatcher& dispatcher, const Predicate& pred, const Args&... args)
+    {
+        flight_call_scope flight_call(Id);
+        out_message request;
+#if __MSG_USE_TRACING__
+        span_scope trace_span(span_kind::client, Id, get_current_trace_context());
+        request.set_trace_context(trace_span.get_context());
+#endif // __MSG_USE_TRACING__
+        request << (uint32_t)Id;
+        if constexpr (sizeof...(args) != 0)
+            (request << ... << args);
+
+        readable_regions regions;
+        (add_readable_region(regions, args), ...);
+
+        in_message response(message::initial_read_size);
+        bool cached = false;
+        if constexpr (cacheable_call<Id>::value)
+        {
+            static_assert(!(is_remote_pointer<Args>::value || ...), "calls with remote pointer arguments can't be cached (pointer values don't identify call)");
+            if (m_cache != nullptr)
+            {
+                std::string key = make_address_key(address);
+                key.append(request.get_payload()); // trace context doesn't affect result
+
+                auto frame = m_cache->get(std::move(key), [&]
+                    {
+                        exchange_by_address(address, connect_attempts, dispatcher, pred, request, response, &regions);
+                        const auto result = response.get_frame();
+                        return std::make_shared<const std::vector<char>>(result.begin(), result.end());
+                    });
+
+                response.assign_frame(frame->data());
+
+                uint32_t callback_id = 0;
+                response >> callback_id;
+                cached = true;
+            }
+        }
+
+        if (!cached)
+            exchange_by_address(address, connect_attempts, dispatcher, pred, request, response, &regions);
+
+        if constexpr (!std::is_same_v<void, R>)
+        {
+            R result{};
+            response >> result;
+    
+            return result;
+        }
+    }
     
-                    return result;
+    template <uint32_t Id, typename R, typename Tuple, typename Dispatcher, typename Predicate, typename... Args>
+    inline R service_invoker::call_by_balancer(load_balancer<Tuple>& balancer, Dispatcher& dispatcher, const Predicate& pred, const Args&... args)
+    {
+        auto lease = balancer.acquire();
+        try
+        {
+            if constexpr (std::is_same_v<void, R>)
+            {
+                call_by_address_proc<Id, R>(lease.get_address(), load_balancer<Tuple>::connect_attempts, dispatcher, pred, args...);
+                lease.complete(true);
+            }
+            else
+            {
+                R result = call_by_address_proc<Id, R>(lease.get_address(), load_balancer<Tuple>::connect_attempts, dispatcher, pred, args...);
+                lease.complete(true);
+                return result;
+            }
+        }
+        catch (const system_error&)
+        {
+            lease.complete(false);
+            throw;
+        }
+    }
+
+    template <uint32_t Id, typename R, typename Tuple, typename Dispatcher, typename Predicate, typename... Args>
+    inline R service_invoker::call_hedged(load_balancer<Tuple>& balancer, double percentile, Dispatcher& dispatcher, const Predicate& pred, const Args&... args)
+    {
+        static_assert(idempotent_call<Id>::value, "only idempotent calls can be hedged");
+
+        const auto delay = balancer.get_latency_percentile(percentile);
+        if (delay == delay.zero() || balancer.size() < 2)
+            return call_by_balancer<Id, R>(balancer, dispatcher, pred, args...);
+
+        flight_call_scope flight_call(Id);
+        out_message request;
+#if __MSG_USE_TRACING__
+        span_scope trace_span(span_kind::client, Id, get_current_trace_context());
+        request.set_trace_context(trace_span.get_context());
+#endif // __MSG_USE_TRACING__
+        request << (uint32_t)Id;
+        if constexpr (sizeof...(args) != 0)
+            (request << ... << args);
+
+        readable_regions regions;
+        (add_readable_region(regions, args), ...);
+
+        in_message response(message::initial_read_size);
+        auto finish = [&](point_to_point_socket& socket, typename load_balancer<Tuple>::lease& lease) -> R
+        {
+            try
+            {
+                exchange_by_channel(socket, dispatcher, pred, request, response, true, &regions);
+                lease.complete(true);
+            }
+            catch (const system_error&)
+            {
+                lease.complete(false);
+                throw;
+            }
+
+            if constexpr (!std::is_same_v<void, R>)
+            {
+                R result{};
+                response >> result;
+                return result;
+            }
+        };
+
+        auto primary_lease = balancer.acquire();
+        std::optional<decltype(make_client_socket(primary_lease.get_address()))> primary;
+        try
+        {
+            std::apply([&primary](const auto&... parts) { primary.emplace(parts..., load_balancer<Tuple>::connect_attempts); }, primary_lease.get_address());
+            primary->write_message(request, pred);
+        }
+        catch (const system_error&)
+        {
+            primary_lease.complete(false);
+            throw;
+        }
+
+        if (wait_for_any({ primary->get_handle() }, std::chrono::duration_cast<std::chrono::microseconds>(delay), pred) < 0)
+        {
+            std::optional<typename load_balancer<Tuple>::lease> hedge_lease;
+            try
+            {
+                hedge_lease.emplace(balancer.acquire_except(primary_lease));
+            }
+            catch (const circuit_open_exception&) {} // there are no available endpoints for hedging, waiting for primary one
+
+            std::optional<decltype(make_client_socket(primary_lease.get_address()))> hedge;
+            if (hedge_lease)
+            {
+                try
+                {
+                    std::apply([&hedge](const auto&... parts) { hedge.emplace(parts..., load_balancer<Tuple>::connect_attempts); }, hedge_lease->get_address());
+                    hedge->write_message(request, pred);
+                }
+                catch (const system_error&)
+                {
+                    hedge_lease->complete(false);
+                    hedge.reset();
+                }
+            }
+
+            if (hedge)
+            {
+                int winner = -1;
+                while (winner < 0)
+                    winner = wait_for_any({ primary->get_handle(), hedge->get_handle() }, std::chrono::seconds(1), pred);
+
+                if (winner == 1)
+                {
+                    try
+                    {
+                        return finish(*hedge, *hedge_lease); // primary lease is released without result reporting
+                    }
+                    catch (const system_error&) {} // hedge endpoint has failed (it is reported by finish), waiting for primary one
                 }
                 else
-                    return;
+                {
+                    try
+                    {
+                        return finish(*primary, primary_lease);
+                    }
+                    catch (const system_error&) {} // primary endpoint has failed (it is reported by finish), waiting for hedge one
+
+                    return finish(*hedge, *hedge_lease);
+                }
             }
         }
+
+        return finish(*primary, primary_lease);
     }
-    
+
     template <uint32_t id, typename R, typename Predicate, typename... Args>
     R service_invoker::call_by_channel(point_to_point_socket& socket, in_message& in_msg, out_message& out_msg, const Predicate& pred, const Args&... args)
     {
         try
         {
-            class message_cleaner
-            {
-                in_message& m_in_msg;
-                out_message& m_out_msg;
-            public:
-                message_cleaner(in_message& in_msg, out_message& out_msg) noexcept : m_in_msg(in_msg), m_out_msg(out_msg) {}
-                ~message_cleaner()
-                {
-                    m_in_msg.clear();
-                    m_out_msg.clear();
-                }
-            } message_state_guard(in_msg, out_msg);
+            message_cleaner message_state_guard(in_msg, out_msg);
 
             out_msg.clear();
+            flight_call_scope flight_call(id);
+#if __MSG_USE_TRACING__
+            span_scope trace_span(span_kind::client, id, get_current_trace_context());
+            out_msg.set_trace_context(trace_span.get_context());
+#endif // __MSG_USE_TRACING__
             out_msg << id;
             if constexpr (sizeof...(args) != 0)
                 (out_msg << ... << args);
@@ -178,4 +716,58 @@ namespace ipc
             throw;
         }
     }
+
+    template <typename Tuple, typename Predicate>
+    inline metrics_snapshot service_invoker::query_metrics(const Tuple& address, const Predicate& pred)
+    {
+        out_message request;
+        request << function_invoker_base::metrics_id;
+
+        in_message response(message::initial_read_size);
+        auto dispatcher = [](uint32_t, in_message&, out_message&) { return false; };
+        exchange_by_address(address, client_socket::default_connect_attempts, dispatcher, pred, request, response);
+
+        metrics_snapshot result;
+        result.deserialize(response);
+        return result;
+    }
+
+    template <typename... T, typename Predicate, typename... Pointers>
+    std::tuple<T...> service_invoker::read_by_channel(point_to_point_socket& socket, in_message& in_msg, out_message& out_msg, const Predicate& pred, const Pointers&... ptrs)
+    {
+        static_assert(sizeof...(T) == sizeof...(Pointers), "one remote pointer is required per value type");
+        static_assert((std::is_convertible_v<const Pointers&, const message::remote_ptr<true>&> && ...), "remote values must be addressed by ipc::message::remote_ptr<true>");
+        static_assert((std::is_trivially_copyable_v<T> && ...), "remote values must be trivially copyable");
+        static_assert((std::is_default_constructible_v<T> && ...), "remote values must be default constructible");
+        constexpr size_t total_size = (sizeof(T) + ... + 0);
+
+        try
+        {
+            message_cleaner message_state_guard(in_msg, out_msg);
+
+            out_msg.clear();
+            out_msg << function_invoker_base::remote_read_tag << (uint32_t)sizeof...(T);
+            ((out_msg << static_cast<const message::remote_ptr<true>&>(ptrs) << (uint32_t)sizeof(T)), ...);
+            socket.write_message(out_msg, pred);
+
+            socket.read_message(in_msg, pred);
+            std::pair<std::array<uint8_t, total_size>, size_t> blob;
+            in_msg >> blob;
+            if (blob.second != total_size)
+                throw_message_too_short_exception(__FUNCTION_NAME__, total_size, blob.second);
+
+            std::tuple<T...> result;
+            std::apply([data = blob.first.data()](T&... values) mutable 
+                { 
+                    ((memcpy(&values, data, sizeof(T)), data += sizeof(T)), ...);
+                }, result);
+
+            return result;
+        }
+        catch (...)
+        {
+            socket.close();
+            throw;
+        }
+    }
 }
@@ -0,0 +1,115 @@
+/**
+ * Lightweight inter process communication library
+ * Copyright (C) 2020 Pavel Kovalenko
+ *
+ * This Source Code Form is subject to the terms of the Mozilla
+ * Public License, v. 2.0. If a copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+/*
+    Inline methods (slowlog.h) implementations. It shouldn't be used directly.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+
+#include "../include/slowlog.hpp"
+
+namespace ipc
+{
+    inline slow_call_log::slow_call_log(std::string_view path, clock::duration threshold, size_t max_rate, size_t dump_size, size_t queue_capacity) :
+        m_file{ std::string(path) },
+        m_threshold(threshold),
+        m_max_rate(max_rate),
+        m_dump_size(dump_size),
+        m_queue_capacity(std::max<size_t>(queue_capacity, 1)),
+        m_window_start(clock::now())
+    {
+        if (!m_file)
+            throw slow_call_log_exception(errno, std::string(__FUNCTION_NAME__) + ": unable to create " + std::string(path));
+
+        m_queue.reserve(m_queue_capacity);
+        m_writer = std::thread(&slow_call_log::writer_proc, this);
+    }
+
+    inline slow_call_log::~slow_call_log()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_stop = true;
+        }
+
+        m_wake.notify_one();
+        m_writer.join();
+    }
+
+    inline bool slow_call_log::submit(slow_call&& call)
+    {
+        if (call.payload.size() > m_dump_size)
+            call.payload.resize(m_dump_size);
+
+        const auto now = clock::now();
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (now - m_window_start >= std::chrono::seconds(1))
+            {
+                m_window_start = now;
+                m_window_count = 0;
+            }
+
+            if (m_window_count >= m_max_rate || m_queue.size() >= m_queue_capacity)
+            {
+                ++m_dropped;
+                ++m_total_dropped;
+                return false;
+            }
+
+            ++m_window_count;
+            m_queue.emplace_back(std::move(call), m_dropped);
+            m_dropped = 0;
+        }
+
+        m_wake.notify_one();
+        return true;
+    }
+
+    inline uint64_t slow_call_log::get_dropped_count() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_total_dropped;
+    }
+
+    inline void slow_call_log::writer_proc()
+    {
+        static const char digits[] = "0123456789abcdef";
+
+        std::vector<std::pair<slow_call, uint64_t>> records;
+        records.reserve(m_queue_capacity);
+        bool stop = false;
+        while (!stop)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                m_wake.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+                records.swap(m_queue);
+                stop = m_stop;
+            }
+
+            for (const auto& [call, dropped] : records)
+            {
+                m_file << "time=" << call.timestamp << " function=" << call.function << " total=" << call.read + call.dispatch + call.write
+                    << " read=" << call.read << " dispatch=" << call.dispatch << " write=" << call.write << " payload=" << call.payload_size << " dump=";
+
+                for (char c : call.payload)
+                    m_file << digits[(uint8_t)c >> 4] << digits[(uint8_t)c & 0xF];
+
+                m_file << " dropped=" << dropped << '\n';
+            }
+
+            m_file.flush();
+            records.clear();
+        }
+    }
+}
@@ -0,0 +1,265 @@
+/**
+ * Lightweight inter process communication library
+ * Copyright (C) 2020 Pavel Kovalenko
+ *
+ * This Source Code Form is subject to the terms of the Mozilla
+ * Public License, v. 2.0. If a copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+/*
+    Inline methods (trace.h) implementations. It shouldn't be used directly.
+*/
+#pragma once
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <string>
+
+#include "../include/trace.hpp"
+
+namespace ipc
+{
+    static inline uint64_t generate_trace_id() noexcept
+    {
+        thread_local std::mt19937_64 generator(std::random_device{}() ^ (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count());
+
+        uint64_t id = 0;
+        while (id == 0)
+            id = generator();
+
+        return id;
+    }
+
+    inline trace_context& get_thread_trace_context() noexcept
+    {
+        thread_local trace_context context;
+        return context;
+    }
+
+    inline trace_context trace_context::start(uint8_t flags) noexcept
+    {
+        trace_context context;
+        context.trace_id = generate_trace_id();
+        context.span_id = generate_trace_id();
+        context.flags = flags;
+        return context;
+    }
+
+    inline trace_context trace_context::make_child() const noexcept
+    {
+        trace_context context = *this;
+        context.span_id = generate_trace_id();
+        return context;
+    }
+
+    inline trace_context get_current_trace_context() noexcept
+    {
+        return get_thread_trace_context();
+    }
+
+    inline trace_scope::trace_scope(const trace_context& context) noexcept : m_previous(get_thread_trace_context())
+    {
+        get_thread_trace_context() = context;
+    }
+
+    inline trace_scope::~trace_scope()
+    {
+        get_thread_trace_context() = m_previous;
+    }
+
+    inline int64_t get_trace_time() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    /*
+        Single writer ring of spans. Each slot is protected by sequence counter (odd value means slot is being written),
+        span is stored as atomic words, so readers of other threads can copy slot without locks and detect torn copies.
+    */
+    class span_ring
+    {
+    public:
+        static constexpr size_t capacity = 1024;
+        static constexpr size_t words_count = (sizeof(span) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+        void push(const span& s) noexcept
+        {
+            std::array<uint64_t, words_count> words = {};
+            memcpy(words.data(), &s, sizeof(span));
+
+            slot& target = m_slots[m_written.load(std::memory_order_relaxed) % capacity];
+            const uint32_t sequence = target.sequence.load(std::memory_order_relaxed);
+            target.sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t i = 0; i < words_count; ++i)
+                target.words[i].store(words[i], std::memory_order_relaxed);
+
+            target.sequence.store(sequence + 2, std::memory_order_release);
+            m_written.fetch_add(1, std::memory_order_release);
+        }
+
+        template <typename Callable>
+        void for_each(const Callable& callable) const
+        {
+            const size_t written = m_written.load(std::memory_order_acquire);
+            for (size_t i = (written > capacity) ? written - capacity : 0; i < written; ++i)
+            {
+                const slot& source = m_slots[i % capacity];
+                const uint32_t sequence = source.sequence.load(std::memory_order_acquire);
+                if (sequence & 1)
+                    continue;
+
+                std::array<uint64_t, words_count> words;
+                for (size_t j = 0; j < words_count; ++j)
+                    words[j] = source.words[j].load(std::memory_order_relaxed);
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (source.sequence.load(std::memory_order_relaxed) != sequence)
+                    continue; // slot has been overwritten during copying
+
+                span s;
+                memcpy(&s, words.data(), sizeof(span));
+                callable(s);
+            }
+        }
+
+        bool owned = true; ///< ring is used by running thread (guarded by registry lock)
+
+    protected:
+        struct slot
+        {
+            std::atomic<uint32_t> sequence = 0;
+            std::array<std::atomic<uint64_t>, words_count> words = {};
+        };
+
+        std::array<slot, capacity> m_slots;
+        std::atomic<size_t> m_written = 0;
+    };
+
+    struct span_registry
+    {
+        std::mutex lock;
+        std::vector<std::shared_ptr<span_ring>> rings; // rings of finished threads are kept to be dumped and reused by new threads
+    };
+
+    inline span_registry& get_span_registry()
+    {
+        static span_registry registry;
+        return registry;
+    }
+
+    inline span_ring* acquire_span_ring() noexcept
+    {
+        try
+        {
+            auto& registry = get_span_registry();
+            std::lock_guard<std::mutex> lock(registry.lock);
+            for (const auto& ring : registry.rings)
+            {
+                if (!ring->owned)
+                {
+                    ring->owned = true; // spans of finished thread are overwritten by new ones
+                    return ring.get();
+                }
+            }
+
+            registry.rings.push_back(std::make_shared<span_ring>());
+            return registry.rings.back().get();
+        }
+        catch (...)
+        {
+            return nullptr; // spans of this thread are not recorded
+        }
+    }
+
+    struct span_ring_owner
+    {
+        span_ring* ring;
+
+        ~span_ring_owner()
+        {
+            if (ring != nullptr)
+            {
+                auto& registry = get_span_registry();
+                std::lock_guard<std::mutex> lock(registry.lock);
+                ring->owned = false;
+            }
+        }
+    };
+
+    inline span_ring* get_thread_span_ring() noexcept
+    {
+        thread_local span_ring_owner owner{ acquire_span_ring() };
+        return owner.ring;
+    }
+
+    inline void record_span(const span& s) noexcept
+    {
+        if (span_ring* ring = get_thread_span_ring(); ring != nullptr)
+            ring->push(s);
+    }
+
+    inline void dump_spans(std::ostream& stream)
+    {
+        std::vector<std::shared_ptr<span_ring>> rings;
+        {
+            auto& registry = get_span_registry();
+            std::lock_guard<std::mutex> lock(registry.lock);
+            rings = registry.rings;
+        }
+
+        const auto flags = stream.flags();
+        for (const auto& ring : rings)
+        {
+            ring->for_each([&stream](const span& s)
+                {
+                    stream << std::hex << std::setfill('0')
+                        << "trace=" << std::setw(16) << s.trace_id << " span=" << std::setw(16) << s.span_id << " parent=" << std::setw(16) << s.parent_id
+                        << std::dec << std::setfill(' ') << " kind=" << (s.kind == span_kind::server ? "server" : "client") << " function=" << s.function
+                        << " start=" << s.start << " read=" << s.read << " dispatch=" << s.dispatch << " end=" << s.end << '\n';
+                });
+        }
+
+        stream.flags(flags);
+    }
+
+    inline bool dump_spans(std::string_view path)
+    {
+        std::ofstream file{ std::string(path) };
+        if (!file)
+            return false;
+
+        dump_spans(file);
+        file.flush();
+        return (bool)file;
+    }
+
+    inline span_scope::span_scope(span_kind kind, uint32_t function, const trace_context& parent, int64_t start) noexcept :
+        m_context(parent.trace_id != 0 ? parent.make_child() : parent), m_previous(get_thread_trace_context()), m_span{}
+    {
+        m_span.trace_id = m_context.trace_id;
+        m_span.span_id = m_context.span_id;
+        m_span.parent_id = parent.span_id;
+        m_span.function = function;
+        m_span.kind = kind;
+        m_span.start = start;
+
+        get_thread_trace_context() = m_context;
+    }
+
+    inline span_scope::~span_scope()
+    {
+        get_thread_trace_context() = m_previous;
+        if (m_context.is_sampled())
+        {
+            if (m_span.end == 0)
+                m_span.end = get_trace_time();
+
+            record_span(m_span);
+        }
+    }
+}
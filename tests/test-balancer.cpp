@@ -0,0 +1,62 @@
+#include <tuple>
+
+#include "balancer.hpp"
+
+int main()
+{
+    typedef std::tuple<const char*, uint16_t> address_t;
+    ipc::load_balancer<address_t> balancer({ { "a", 1 }, { "b", 2 } }, ipc::balancing_policy::least_outstanding, 2);
+
+    bool ok = true;
+    {
+        auto busy = balancer.acquire();
+        for (int i = 0; i < 16 && ok; ++i)
+        {
+            auto other = balancer.acquire();
+            ok = (std::get<1>(other.get_address()) != std::get<1>(busy.get_address())); // two choices of two endpoints: less loaded wins
+        }
+    }
+
+    for (int failures = 0; failures < 2;)
+    {
+        auto lease = balancer.acquire();
+        if (std::get<1>(lease.get_address()) == 1)
+        {
+            lease.complete(false);
+            ++failures;
+        }
+    }
+
+    for (int i = 0; i < 16 && ok; ++i)
+        ok = (std::get<1>(balancer.acquire().get_address()) == 2); // the first endpoint is ejected
+
+    ok = ok && balancer.get_latency_percentile(0.95) == balancer.get_latency_percentile(0.5); // no successful calls yet
+    balancer.acquire().complete(true);
+    ok = ok && balancer.get_latency_percentile(0.95).count() > 0;
+
+    {
+        auto busy = balancer.acquire();
+        try
+        {
+            balancer.acquire_except(busy);
+            ok = false;
+        }
+        catch (const ipc::circuit_open_exception&) {} // the only available endpoint is busy
+    }
+
+    ipc::circuit_breaker breaker(2, std::chrono::hours(1));
+    breaker.report(false);
+    ok = ok && breaker.try_acquire() && breaker.get_state() == ipc::circuit_breaker::state_t::closed;
+    breaker.report(false);
+    ok = ok && !breaker.try_acquire() && breaker.get_state() == ipc::circuit_breaker::state_t::open;
+    breaker.probe_succeeded();
+    ok = ok && breaker.try_acquire() && breaker.get_state() == ipc::circuit_breaker::state_t::half_open && !breaker.try_acquire(); // single trial call
+    breaker.report(false);
+    ok = ok && !breaker.is_available() && breaker.get_state() == ipc::circuit_breaker::state_t::open;
+    breaker.probe_succeeded();
+    ok = ok && breaker.try_acquire();
+    breaker.report(true);
+    ok = ok && breaker.get_state() == ipc::circuit_breaker::state_t::closed;
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "broadcast.hpp"
+
+int main()
+{
+    const std::string path = "test-broadcast.shm";
+    ipc::broadcast_channel channel(path, 4096);
+    ipc::broadcast_receiver first(path), second(path);
+
+    ipc::out_message out;
+    ipc::in_message in;
+    bool ok = !first.try_receive(in);
+
+    // every receiver gets the same messages
+    for (int32_t i = 0; i < 3; ++i)
+    {
+        out.clear();
+        out << i << std::string_view("message");
+        channel.publish(out);
+    }
+
+    for (auto* receiver : { &first, &second })
+        for (int32_t i = 0; i < 3; ++i)
+        {
+            int32_t n = -1;
+            std::string s;
+            ok = ok && receiver->try_receive(in);
+            in >> n >> s;
+            ok = ok && n == i && s == "message";
+        }
+
+    ok = ok && !first.try_receive(in) && !second.try_receive(in) && first.get_lost_count() == 0;
+
+    // receiver that falls behind loses overwritten messages only
+    const std::vector<uint8_t> payload(200, 0x5A);
+    for (int32_t i = 3; i < 100; ++i)
+    {
+        out.clear();
+        out << i << std::make_pair(payload.data(), payload.size());
+        channel.publish(out);
+    }
+
+    int32_t received = 0, last = -1;
+    std::vector<uint8_t> blob;
+    while (first.try_receive(in))
+    {
+        in >> last >> blob;
+        ok = ok && blob == payload;
+        ++received;
+    }
+
+    ok = ok && last == 99 && first.get_lost_count() > 0 && received + first.get_lost_count() == 97;
+
+    // concurrent reading never returns partially overwritten message
+    int32_t drained = 0;
+    while (second.try_receive(in))
+        ++drained;
+
+    const int32_t count = 20000;
+    std::thread producer([&channel, count]
+        {
+            ipc::out_message msg;
+            std::vector<uint8_t> data;
+            for (int32_t i = 100; i < 100 + count; ++i)
+            {
+                data.assign(16 + i % 300, (uint8_t)i);
+                msg.clear();
+                msg << i << std::make_pair(data.data(), data.size());
+                channel.publish(msg);
+            }
+        });
+
+    int32_t previous = 99;
+    received = 0;
+    while (previous != 99 + count && ok)
+    {
+        if (!second.try_receive(in))
+            continue;
+
+        int32_t n = -1;
+        in >> n >> blob;
+        ok = ok && n > previous && blob.size() == (size_t)(16 + n % 300) && blob == std::vector<uint8_t>(blob.size(), (uint8_t)n);
+        previous = n;
+        ++received;
+    }
+
+    producer.join();
+    ok = ok && second.get_lost_count() + received + drained + 3 == channel.get_published_count();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "cache.hpp"
+
+static ipc::response_cache::frame_ptr make_frame(const char* s)
+{
+    return std::make_shared<const std::vector<char>>(s, s + strlen(s));
+}
+
+int main()
+{
+    ipc::response_cache cache(1024, 1);
+
+    cache.insert("a", make_frame("1"), std::chrono::seconds(10));
+    cache.insert("b", make_frame("2"), std::chrono::milliseconds(1));
+    auto a = cache.find("a");
+    bool ok = (a && (*a)[0] == '1');
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    ok = ok && !cache.find("b"); // expired
+
+    std::string big(600, 'x');
+    cache.insert("c", make_frame(big.c_str()), std::chrono::seconds(10));
+    cache.insert("d", make_frame(big.c_str()), std::chrono::seconds(10));
+    ok = ok && !cache.find("c") && cache.find("d"); // least recently used is evicted
+
+    cache.insert(std::string(2048, 'k'), make_frame("3"), std::chrono::seconds(10));
+    ok = ok && !cache.find(std::string(2048, 'k')); // too large
+
+    std::atomic<int> calls = 0;
+    ipc::call_cache calls_cache(1024, std::chrono::seconds(10));
+    std::vector<std::thread> callers;
+    std::vector<ipc::call_cache::frame_ptr> results(8);
+    for (size_t i = 0; i < results.size(); ++i)
+        callers.emplace_back([&, i]
+            {
+                results[i] = calls_cache.get("key", [&]
+                    {
+                        ++calls;
+                        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                        return make_frame("4");
+                    });
+            });
+
+    for (auto& caller : callers)
+        caller.join();
+
+    for (const auto& result : results)
+        ok = ok && result && (*result)[0] == '4';
+    ok = ok && calls == 1; // concurrent identical calls are coalesced and cached
+
+    return ok ? 0 : 1;
+}
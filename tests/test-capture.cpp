@@ -0,0 +1,27 @@
+#include <string>
+
+#include "capture.hpp"
+
+int main()
+{
+    const std::string path = "test-capture.log";
+    ipc::out_message request, response;
+    request << (uint32_t)1 << std::string_view("request");
+    response << (uint32_t)2;
+
+    bool ok = true;
+    {
+        ipc::capture_log log(path, 128);
+        const uint64_t id = log.make_connection_id();
+        ok = log.append(id, request.get_data().data(), false) && log.append(id, response.get_data().data(), true);
+        ok = ok && !log.append(id, request.get_data().data(), false) && log.get_dropped_count() == 1; // log is full
+    }
+
+    ipc::capture_reader reader(path);
+    ipc::capture_record r;
+    ok = ok && reader.next(r) && !r.written && r.connection_id == 1 && r.message.size() == request.get_data().size();
+    ok = ok && reader.next(r) && r.written && std::string(r.message) == std::string(response.get_data().begin(), response.get_data().end());
+    ok = ok && !reader.next(r);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "rpc.hpp"
+
+static std::atomic<bool> g_stop = false;
+static std::atomic<bool> g_ready = false;
+static std::atomic<int32_t> g_invocations = 0;
+static auto predicate = [] { return !g_stop; };
+
+class dispatcher
+{
+public:
+    void invoke(uint32_t id, ipc::in_message& in_msg, ipc::out_message& out_msg, ipc::point_to_point_socket&) const
+    {
+        if (id == 1) // slow handler keeps the first call running while identical ones arrive
+            ipc::function_invoker<int32_t(int32_t), true>()(in_msg, out_msg, [](int32_t x)
+                {
+                    const int32_t invocation = ++g_invocations;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+                    return x * 100 + invocation;
+                });
+    }
+
+    bool is_idempotent(uint32_t id) const { return id == 1; }
+    void report_error(const std::exception_ptr&) const {}
+    void ready() const { g_ready = true; }
+};
+
+// worker threads count doesn't depend on number of cores of test machine
+class server_t : public ipc::rpc_server<ipc::unix_server_socket>
+{
+public:
+    using rpc_server::rpc_server;
+    using rpc_server::run_threads;
+};
+
+static bool client_dispatch(uint32_t, ipc::in_message&, ipc::out_message&)
+{
+    return false;
+}
+
+int main()
+{
+    signal(SIGPIPE, SIG_IGN);
+
+    const char* path = "test-coalescing.sock";
+    const size_t clients_count = 8;
+    server_t server(path);
+    std::thread server_thread([&server] { server.run_threads(dispatcher(), predicate, clients_count, true); });
+    while (!g_ready)
+        std::this_thread::yield();
+
+    std::vector<int32_t> results(clients_count, 0);
+    std::vector<std::thread> clients;
+    for (size_t i = 0; i < clients_count; ++i)
+        clients.emplace_back([&results, path, i]
+            {
+                try
+                {
+                    results[i] = ipc::service_invoker().call_by_address<1, int32_t>(std::tuple{ path }, client_dispatch, predicate, (int32_t)7);
+                }
+                catch (const std::exception&) {}
+            });
+
+    for (auto& client : clients)
+        client.join();
+
+    bool ok = g_invocations == 1;
+    for (int32_t result : results)
+        ok = ok && result == 701; // every caller got response of the only invocation
+
+    g_stop = true;
+    server_thread.join();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+#include <csignal>
+#include <cstring>
+#include <thread>
+
+#include "ipc.hpp"
+
+static auto predicate = [] { return true; };
+
+// sends raw length prefix (and some payload) and checks how server side reads it
+template <typename Exception>
+static bool rejected(ipc::unix_server_socket& server, const char* path, __MSG_LENGTH_TYPE__ length)
+{
+    std::thread client_thread([path, length]
+        {
+            ipc::unix_client_socket client(path);
+            char frame[64] = {};
+            memcpy(frame, &length, sizeof(length));
+            send(client.get_handle(), frame, sizeof(frame), 0);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        });
+
+    bool result = false;
+    try
+    {
+        auto channel = server.accept(predicate);
+        ipc::in_message message;
+        channel.read_message(message, predicate);
+    }
+    catch (const Exception&)
+    {
+        result = true;
+    }
+    catch (...)
+    {
+        client_thread.join();
+        throw; // unexpected exception fails the test
+    }
+
+    client_thread.join();
+    return result;
+}
+
+int main()
+{
+    signal(SIGPIPE, SIG_IGN);
+
+    const char* path = "test-frame.sock";
+    ipc::unix_server_socket server(path);
+
+    bool ok = true;
+    try
+    {
+        ok = rejected<ipc::bad_message_exception>(server, path, 0);
+        ok = ok && rejected<ipc::bad_message_exception>(server, path, sizeof(__MSG_LENGTH_TYPE__) - 1);
+        ok = ok && rejected<ipc::message_overflow_exception>(server, path, msg_max_length + 1);
+        ok = ok && !rejected<std::exception>(server, path, 64); // valid frame
+    }
+    catch (...)
+    {
+        ok = false;
+    }
+
+    return ok ? 0 : 1;
+}
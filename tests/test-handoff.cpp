@@ -0,0 +1,115 @@
+#include <atomic>
+#include <csignal>
+#include <memory>
+#include <thread>
+#include <tuple>
+
+#include <unistd.h>
+
+#include "rpc.hpp"
+
+static std::atomic<bool> g_stop = false;
+static auto predicate = [] { return !g_stop; };
+
+class dispatcher
+{
+public:
+    explicit dispatcher(int32_t generation) noexcept : m_generation(generation) {}
+
+    void invoke(uint32_t id, ipc::in_message& in_msg, ipc::out_message& out_msg, ipc::point_to_point_socket&) const
+    {
+        if (id == 1) // answer identifies server that has processed the call
+            ipc::function_invoker<int32_t(), true>()(in_msg, out_msg, [this] { return m_generation; });
+    }
+
+    void report_error(const std::exception_ptr& e) const
+    {
+        try
+        {
+            std::rethrow_exception(e);
+        }
+        catch (const ipc::user_stop_request_exception&) {} // server is stopped by predicate
+        catch (...)
+        {
+            ++m_errors;
+        }
+    }
+
+    void ready() const {}
+
+    int get_errors_count() const noexcept { return m_errors; }
+
+protected:
+    const int32_t m_generation;
+    mutable std::atomic<int> m_errors = 0;
+};
+
+static bool client_dispatch(uint32_t, ipc::in_message&, ipc::out_message&)
+{
+    return false;
+}
+
+int main()
+{
+    signal(SIGPIPE, SIG_IGN);
+
+    const char* path = "test-handoff.sock";
+    const char* control_path = "test-handoff-control.sock";
+    const dispatcher old_dispatcher(1), new_dispatcher(2);
+
+    auto old_server = std::make_unique<ipc::rpc_server<ipc::unix_server_socket>>(path);
+    old_server->enable_handoff(control_path);
+    std::thread old_thread([&old_server, &old_dispatcher] { old_server->run(old_dispatcher, predicate); });
+
+    // client calls service without pauses during the whole switch, every call must succeed
+    std::atomic<bool> calling = true;
+    std::atomic<int> failures = 0, old_answers = 0, new_answers = 0;
+    std::thread client([&]
+        {
+            while (calling)
+            {
+                try
+                {
+                    const int32_t generation = ipc::service_invoker().call_by_address<1, int32_t>(std::tuple{ path }, client_dispatch, predicate);
+                    ++(generation == 1 ? old_answers : new_answers);
+                }
+                catch (const std::exception&)
+                {
+                    ++failures;
+                }
+            }
+        });
+
+    while (old_answers < 10)
+        std::this_thread::yield();
+
+    std::unique_ptr<ipc::rpc_server<ipc::unix_server_socket>> new_server;
+    std::thread new_thread;
+    try
+    {
+        new_server = std::make_unique<ipc::rpc_server<ipc::unix_server_socket>>(path, ipc::take_over_listener(control_path, predicate, 10));
+        new_thread = std::thread([&new_server, &new_dispatcher] { new_server->run(new_dispatcher, predicate); });
+    }
+    catch (const std::exception&)
+    {
+        ++failures;
+    }
+
+    old_thread.join(); // old server returns after finishing accepted connections
+    old_server.reset(); // shared socket file is not removed by old server
+    bool ok = access(path, F_OK) == 0;
+
+    const int switched = new_answers;
+    while (new_server && new_answers < switched + 10)
+        std::this_thread::yield();
+
+    calling = false;
+    client.join();
+    g_stop = true;
+    if (new_thread.joinable())
+        new_thread.join();
+
+    ok = ok && failures == 0 && old_answers >= 10 && new_answers >= 10;
+    ok = ok && old_dispatcher.get_errors_count() == 0 && new_dispatcher.get_errors_count() == 0;
+    return ok ? 0 : 1;
+}
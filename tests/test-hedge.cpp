@@ -0,0 +1,92 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <optional>
+#include <thread>
+#include <tuple>
+
+#include "rpc.hpp"
+
+namespace ipc
+{
+    template <>
+    struct idempotent_call<1>
+    {
+        static const bool value = true;
+    };
+}
+
+static std::atomic<bool> g_stop = false;
+static auto predicate = [] { return !g_stop; };
+
+class dispatcher
+{
+public:
+    void invoke(uint32_t id, ipc::in_message& in_msg, ipc::out_message& out_msg, ipc::point_to_point_socket&) const
+    {
+        if (id == 1) // slow answer makes client hedge the call
+            ipc::function_invoker<int32_t(int32_t), true>()(in_msg, out_msg, [](int32_t x)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+                    return x * 2;
+                });
+    }
+
+    void report_error(const std::exception_ptr&) const {}
+    void ready() const {}
+};
+
+static bool client_dispatch(uint32_t, ipc::in_message&, ipc::out_message&)
+{
+    return false;
+}
+
+int main()
+{
+    signal(SIGPIPE, SIG_IGN);
+
+    const char* path = "test-hedge.sock";
+    const char* broken_path = "test-hedge-broken.sock";
+    ipc::rpc_server<ipc::unix_server_socket> server(path);
+    std::thread server_thread([&server] { server.run(dispatcher(), predicate); });
+
+    ipc::unix_server_socket broken(broken_path);
+    std::thread broken_thread([&broken]
+        {
+            try
+            {
+                while (predicate())
+                {
+                    auto client = broken.accept(predicate);
+                    ipc::in_message request;
+                    client.read_message(request, predicate); // connection is closed right after request reading
+                }
+            }
+            catch (const std::exception&) {}
+        });
+
+    typedef std::tuple<const char*> address_t;
+    ipc::load_balancer<address_t> balancer({ { path }, { broken_path } });
+    balancer.acquire().complete(true); // short latency sample makes hedging delay short
+
+    bool ok = true;
+    try
+    {
+        std::optional<ipc::load_balancer<address_t>::lease> busy;
+        while (!busy || std::get<0>(busy->get_address()) != broken_path)
+            busy.emplace(balancer.acquire());
+
+        // working endpoint is primary (broken one is busy), broken endpoint is hedge that answers first by closing connection
+        ipc::service_invoker invoker;
+        ok = invoker.call_hedged<1, int32_t>(balancer, 0.5, client_dispatch, predicate, (int32_t)21) == 42;
+    }
+    catch (const std::exception&)
+    {
+        ok = false;
+    }
+
+    g_stop = true;
+    server_thread.join();
+    broken_thread.join();
+    return ok ? 0 : 1;
+}
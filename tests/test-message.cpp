@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <vector>
 
 #include "ipc.hpp"
 
@@ -10,12 +11,142 @@ int main()
     
     ipc::out_message out;
     out << s1 << c1 << i1;
+    bool ok = out.get_data().is_inline(); // small message doesn't use heap
     
     ipc::in_message in;
     const auto& out_data = out.get_data();
     std::copy(out_data.begin(), out_data.end(), in.get_data().begin());
     
     in >> s2 >> c2 >> i2;
-    
-    return (s1 == s2 && c1 == c2 && i1 == i2) ? 0 : 1;
-}
\ No newline at end of file
+    ok = ok && s1 == s2 && c1 == c2 && i1 == i2;
+
+    const std::string long_string(ipc::message_buffer::inline_capacity * 2, 'x');
+    out.clear();
+    out << i1 << long_string << i1;
+    ok = ok && !out.get_data().is_inline();
+
+    in.clear();
+    std::copy(out_data.begin(), out_data.end(), in.get_data().begin());
+    in >> i2 >> s2;
+    ok = ok && i2 == i1 && s2 == long_string;
+
+    ipc::in_message compact(ipc::message::initial_read_size); // buffer grows to assigned message
+    compact.assign_frame(out_data.data());
+    compact >> i2 >> s2;
+    ok = ok && i2 == i1 && s2 == long_string && compact.get_data().size() == out_data.size();
+
+    // length header counts every serialized field (strings don't add their size twice, blob length prefix is counted)
+    const uint8_t bytes[] = { 1, 2, 3 };
+    out.clear();
+    out << s1 << std::make_pair(bytes, sizeof(bytes)) << long_string << std::make_pair(bytes, sizeof(bytes));
+    ok = ok && *(const __MSG_LENGTH_TYPE__*)out_data.data() == out_data.size();
+    std::vector<uint8_t> bytes_copy;
+    in.clear();
+    std::copy(out_data.begin(), out_data.end(), in.get_data().begin());
+    in >> s2 >> bytes_copy;
+    ok = ok && s2 == s1 && bytes_copy == std::vector<uint8_t>(std::begin(bytes), std::end(bytes));
+    in >> s2 >> bytes_copy;
+    ok = ok && s2 == long_string && bytes_copy.size() == sizeof(bytes);
+
+    ipc::request_arena arena(1024);
+    {
+        ipc::request_arena::scope scope(arena);
+        ipc::out_message arena_out;
+        arena_out << long_string;
+        ok = ok && ipc::get_message_resource() == arena.get_resource() && arena_out.get_data().get_resource() == arena.get_resource();
+        ok = ok && out.get_data().get_resource() != arena.get_resource(); // message created before scope keeps its resource
+    }
+    ok = ok && ipc::get_message_resource() == std::pmr::new_delete_resource();
+
+    out.clear();
+    out << long_string;
+    const char* storage = out.get_data().data();
+    std::vector<ipc::out_message> pool;
+    pool.push_back(std::move(out)); // heap storage is moved, not copied
+    ok = ok && pool.back().get_data().data() == storage && out.get_data().size() < pool.back().get_data().size();
+
+    ipc::out_message other;
+    other << i1;
+    other.swap(pool.back());
+    ok = ok && other.get_data().data() == storage;
+    other.clear();
+    other.shrink();
+    ok = ok && other.get_data().is_inline();
+    other << i1;
+
+    in.clear();
+    in.get_data().assign(other.get_data().begin(), other.get_data().end());
+    in.reserve(1024);
+    ipc::in_message moved(std::move(in));
+    i2 = 0;
+    moved >> i2;
+    ok = ok && i2 == i1 && !moved.get_data().is_inline() && in.get_data().is_inline();
+
+    // random access to fields and forwarding of unparsed tail
+    out.clear();
+    out << (uint32_t)7 << s1 << std::make_pair((const uint8_t*)s1.data(), s1.size()) << i1 << c1;
+    in.clear();
+    in.get_data().assign(out_data.begin(), out_data.end());
+    ok = ok && in.build_index() == 5;
+    in.seek(3) >> i2;
+    ok = ok && i2 == i1;
+
+    ipc::out_message forwarded;
+    forwarded << (uint32_t)8;
+    forwarded.append_fields(in.get_fields(1));
+    in.clear();
+    in.get_data().assign(forwarded.get_data().begin(), forwarded.get_data().end());
+    std::vector<uint8_t> blob;
+    uint32_t u = 0;
+    in >> u >> s2 >> blob >> i2 >> c2;
+    ok = ok && u == 8 && s2 == s1 && blob.size() == s1.size() && i2 == i1 && c2 == c1;
+
+    // strings are extracted without copying and may contain zeros (unless legacy encoding is used)
+#if __MSG_LEGACY_STRINGS__
+    const std::string_view text("ab");
+#else
+    const std::string_view text("a\0b", 3);
+#endif // __MSG_LEGACY_STRINGS__
+    out.clear();
+    out << text << s1;
+    in.clear();
+    in.get_data().assign(out_data.begin(), out_data.end());
+    std::string_view view;
+    in >> view >> s2;
+    ok = ok && view == text && view.data() > in.get_data().data() && view.data() < in.get_data().end() && s2 == s1;
+
+    // one pass validation and unchecked extraction
+    out.clear();
+    out << i1 << s1 << std::make_pair((const uint8_t*)s1.data(), s1.size()) << ipc::message::remote_ptr<false>(&i1);
+    in.clear();
+    in.get_data().assign(out_data.begin(), out_data.end());
+    std::pair<std::array<uint8_t, 16>, size_t> small_blob;
+    ipc::message::remote_ptr<true> p;
+    in.validate<int32_t, std::string, std::pair<std::array<uint8_t, 16>, size_t>, ipc::message::remote_ptr<true>>();
+    in.get_unchecked(i2).get_unchecked(s2).get_unchecked(small_blob).get_unchecked(p);
+    ok = ok && i2 == i1 && s2 == s1 && small_blob.second == s1.size() && p.get_pointer() == &i1;
+
+    auto rejected = [&](auto&& validate)
+    {
+        in.clear();
+        in.get_data().assign(out_data.begin(), out_data.end());
+        try
+        {
+            validate();
+        }
+        catch (const std::logic_error&)
+        {
+            return !in;
+        }
+
+        return false;
+    };
+    ok = ok && rejected([&] { in.validate<int32_t, std::string, std::vector<uint8_t>>(true); }); // unexpected data after the last field
+    ok = ok && !rejected([&] { in.validate<int32_t, std::string, std::vector<uint8_t>>(); }); // trailing data is tolerated by default
+    ok = ok && rejected([&] { in.validate<int32_t, std::string, std::pair<std::array<uint8_t, 2>, size_t>, ipc::message::remote_ptr<true>>(); }); // blob is too long
+#if __MSG_USE_TAGS__
+    ok = ok && rejected([&] { in.validate<uint32_t, std::string, std::vector<uint8_t>, ipc::message::remote_ptr<true>>(); }); // type mismatch
+#endif // __MSG_USE_TAGS__
+
+    return ok ? 0 : 1;
+}
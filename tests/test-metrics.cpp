@@ -0,0 +1,42 @@
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+#include "metrics.hpp"
+
+int main()
+{
+    ipc::server_metrics metrics;
+    metrics.add_workers(4);
+    {
+        ipc::server_metrics::connection_scope connection(&metrics);
+        for (int i = 1; i <= 100; ++i)
+            metrics.record_call(7, std::chrono::microseconds(i));
+
+        metrics.record_call(9, std::chrono::milliseconds(5));
+    }
+
+    ipc::server_metrics::connection_scope disabled(nullptr);
+    for (uint32_t id = 100; id < 100 + ipc::server_metrics::max_functions; ++id) // the table is full
+        metrics.record_call(id, std::chrono::nanoseconds(1));
+
+    metrics.record_error();
+
+    ipc::out_message out_msg;
+    metrics.get_snapshot(123).serialize(out_msg);
+
+    ipc::in_message in_msg;
+    std::copy(out_msg.get_data().begin(), out_msg.get_data().end(), in_msg.get_data().begin());
+
+    ipc::metrics_snapshot s;
+    s.deserialize(in_msg);
+
+    bool ok = s.workers == 4 && s.active_connections == 0 && s.connections == 1 && s.errors == 1 && s.cache_memory == 123 && s.untracked_calls == 2;
+    ok = ok && s.functions.size() == ipc::server_metrics::max_functions && s.functions[0].function == 7 && s.functions[1].function == 9;
+
+    const auto& f = s.functions[0];
+    ok = ok && f.calls == 100 && f.total == 5050000 && f.max == 100000;
+    ok = ok && f.p50 >= 50000 && f.p50 <= 2 * 50000 && f.p99 >= 99000 && f.p99 <= f.max; // power of two estimations
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <set>
+#include <thread>
+#include <tuple>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "rpc.hpp"
+
+static volatile sig_atomic_t g_stop = 0;
+static auto predicate = [] { return g_stop == 0; };
+static auto client_predicate = [] { return true; };
+
+static void on_stop(int)
+{
+    g_stop = 1;
+}
+
+class dispatcher
+{
+public:
+    void invoke(uint32_t id, ipc::in_message& in_msg, ipc::out_message& out_msg, ipc::point_to_point_socket&) const
+    {
+        if (id == 1) // busy worker doesn't accept, so concurrent calls are processed by different workers
+            ipc::function_invoker<int32_t(), true>()(in_msg, out_msg, []
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                    return (int32_t)getpid();
+                });
+    }
+
+    void report_error(const std::exception_ptr&) const {}
+    void ready() const {}
+};
+
+static bool client_dispatch(uint32_t, ipc::in_message&, ipc::out_message&)
+{
+    return false;
+}
+
+// supervisor process: returns 0 if all workers and only them have been reaped
+static int supervise(const char* path)
+{
+    const pid_t other = fork(); // child that isn't a worker must be left to its owner
+    if (other == 0)
+        _exit(7);
+
+    signal(SIGTERM, on_stop);
+    ipc::rpc_server<ipc::unix_server_socket> server(path);
+    server.run_prefork(dispatcher(), predicate, 2);
+
+    int status = 0;
+    if (waitpid(other, &status, 0) != other || !WIFEXITED(status) || WEXITSTATUS(status) != 7)
+        return 1;
+
+    return (waitpid(-1, nullptr, WNOHANG) < 0 && errno == ECHILD) ? 0 : 2; // no zombie workers
+}
+
+// pids of workers that have processed two concurrent calls
+static std::set<int32_t> get_workers(const char* path)
+{
+    std::set<int32_t> pids;
+    auto call = [path]
+        {
+            try
+            {
+                return ipc::service_invoker().call_by_address<1, int32_t>(std::tuple{ path }, client_dispatch, client_predicate);
+            }
+            catch (const std::exception&)
+            {
+                return 0;
+            }
+        };
+
+    int32_t second = 0;
+    std::thread worker([&second, &call] { second = call(); });
+    pids.insert(call());
+    worker.join();
+    pids.insert(second);
+    pids.erase(0);
+    return pids;
+}
+
+int main()
+{
+    signal(SIGPIPE, SIG_IGN);
+
+    const char* path = "test-prefork.sock";
+    const pid_t supervisor = fork(); // supervisor is forked before any thread is started
+    if (supervisor == 0)
+        _exit(supervise(path));
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    std::set<int32_t> workers;
+    while (workers.size() != 2 && std::chrono::steady_clock::now() < deadline)
+        workers = get_workers(path);
+
+    bool ok = workers.size() == 2;
+    if (ok) // crashed worker is respawned
+    {
+        const pid_t crashed = *workers.begin();
+        kill(crashed, SIGKILL);
+
+        bool respawned = false;
+        while (!respawned && std::chrono::steady_clock::now() < deadline)
+        {
+            const auto current = get_workers(path);
+            respawned = current.size() == 2 && current.count(crashed) == 0;
+        }
+
+        ok = respawned;
+    }
+
+    kill(supervisor, SIGTERM);
+    int status = 0;
+    ok = ok && waitpid(supervisor, &status, 0) == supervisor && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    return ok ? 0 : 1;
+}
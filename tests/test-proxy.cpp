@@ -0,0 +1,133 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <thread>
+#include <tuple>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "proxy.hpp"
+#include "rpc.hpp"
+
+static std::atomic<bool> g_stop = false;
+static auto predicate = [] { return !g_stop; };
+
+typedef ipc::load_balancer<std::tuple<const char*>> balancer_t;
+
+class dispatcher
+{
+public:
+    void invoke(uint32_t id, ipc::in_message& in_msg, ipc::out_message& out_msg, ipc::point_to_point_socket& p2p_socket) const
+    {
+        if (id == 1)
+            ipc::function_invoker<int32_t(int32_t, int32_t), true>()(in_msg, out_msg, [](int32_t a, int32_t b) { return a + b; });
+        else if (id == 2) // the second argument is requested from client by callback
+            ipc::function_invoker<int32_t(int32_t), true>()(in_msg, out_msg, [&](int32_t a) { return a + ipc::service_invoker().call_by_channel<10, int32_t>(p2p_socket, in_msg, out_msg, predicate); });
+    }
+
+    void report_error(const std::exception_ptr&) const {}
+    void ready() const {}
+};
+
+class router
+{
+public:
+    explicit router(balancer_t& balancer) noexcept : m_balancer(balancer) {}
+
+    balancer_t& route(uint32_t) const noexcept { return m_balancer; }
+    void report_error(const std::exception_ptr&) const { ++m_errors; }
+    void ready() const {}
+
+    int get_errors_count() const noexcept { return m_errors; }
+
+protected:
+    balancer_t& m_balancer;
+    mutable std::atomic<int> m_errors = 0;
+};
+
+static bool client_dispatch(uint32_t id, ipc::in_message& in_msg, ipc::out_message& out_msg)
+{
+    if (id != 10)
+        return false;
+
+    ipc::function_invoker<int32_t(), false>()(in_msg, out_msg, [] { return 5; });
+    return true;
+}
+
+// data that can't be written to failed destination is not forwarded to the next one
+static bool relay_discards_unsent_data()
+{
+    int failed[2], source[2], destination[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, failed) != 0 || socketpair(AF_UNIX, SOCK_STREAM, 0, source) != 0 || socketpair(AF_UNIX, SOCK_STREAM, 0, destination) != 0)
+        return false;
+
+    ipc::socket_relay relay;
+    bool ok = false;
+    send(source[0], "stale", 5, 0);
+    ::close(failed[1]);
+    try
+    {
+        relay.forward(source[1], failed[0], predicate);
+    }
+    catch (const ipc::socket_write_exception&)
+    {
+        ok = true;
+    }
+
+    char data[16] = {};
+    send(source[0], "fresh", 5, 0);
+    ok = ok && relay.forward(source[1], destination[0], predicate);
+    ok = ok && recv(destination[1], data, sizeof(data), 0) == 5 && memcmp(data, "fresh", 5) == 0;
+
+    for (int handle : { failed[0], source[0], source[1], destination[0], destination[1] })
+        ::close(handle);
+
+    return ok;
+}
+
+int main()
+{
+    signal(SIGPIPE, SIG_IGN);
+
+    const char* backend_path = "test-proxy-backend.sock";
+    const char* proxy_path = "test-proxy.sock";
+    balancer_t balancer({ std::tuple{ backend_path } }, ipc::balancing_policy::least_outstanding, 1); // the first backend failure ejects it
+    router r(balancer);
+
+    ipc::rpc_server<ipc::unix_server_socket> server(backend_path);
+    ipc::rpc_proxy<ipc::unix_server_socket> proxy(proxy_path);
+    proxy.set_idle_timeout(std::chrono::milliseconds(100));
+    std::thread server_thread([&server] { server.run(dispatcher(), predicate); });
+    std::thread proxy_thread([&proxy, &r] { proxy.run(r, predicate, 2); });
+
+    bool ok = relay_discards_unsent_data();
+    try
+    {
+        ok = ok && ipc::service_invoker().call_by_address<1, int32_t>(std::tuple{ proxy_path }, client_dispatch, predicate, 2, 3) == 5;
+        ok = ok && ipc::service_invoker().call_by_address<2, int32_t>(std::tuple{ proxy_path }, client_dispatch, predicate, 2) == 7; // callback is relayed
+
+        {
+            ipc::unix_client_socket idle(proxy_path);
+            ipc::out_message request;
+            ipc::in_message response;
+            request << (uint32_t)1 << (int32_t)2 << (int32_t)3;
+            idle.write_message(request, predicate);
+            idle.read_message(response, predicate);
+            std::this_thread::sleep_for(std::chrono::milliseconds(300)); // client keeps connection idle, proxy closes it by timeout
+        }
+
+        ok = ok && ipc::service_invoker().call_by_address<1, int32_t>(std::tuple{ proxy_path }, client_dispatch, predicate, 4, 5) == 9; // backend isn't ejected
+    }
+    catch (const std::exception&)
+    {
+        ok = false;
+    }
+
+    g_stop = true;
+    server_thread.join();
+    proxy_thread.join();
+
+    return ok && r.get_errors_count() == 1 ? 0 : 1; // idle timeout is reported
+}
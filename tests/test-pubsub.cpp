@@ -0,0 +1,100 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <thread>
+#include <vector>
+
+#include "pubsub.hpp"
+
+static std::atomic<bool> g_stop = false;
+static auto predicate = [] { return !g_stop; };
+
+class handler
+{
+public:
+    void report_error(const std::exception_ptr&) const { ++m_errors; }
+    void ready() const {}
+
+    int get_errors_count() const noexcept { return m_errors; }
+
+protected:
+    mutable std::atomic<int> m_errors = 0;
+};
+
+typedef ipc::pubsub_server<ipc::unix_server_socket> server_t;
+typedef ipc::pubsub_client<ipc::unix_client_socket> client_t;
+
+static bool wait_for_subscribers(const server_t& server, std::string_view topic, size_t count)
+{
+    for (int i = 0; i < 500 && server.get_subscribers_count(topic) != count; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    return server.get_subscribers_count(topic) == count;
+}
+
+int main()
+{
+    signal(SIGPIPE, SIG_IGN);
+
+    const char* path = "test-pubsub.sock";
+    handler h;
+    server_t server(path);
+    server.set_queue_capacity(4);
+    std::thread server_thread([&server, &h] { server.run(h, predicate, 3); });
+
+    bool ok = true;
+    try
+    {
+        client_t first(path), second(path), slow(path);
+        first.subscribe("a", predicate);
+        first.subscribe("b", predicate);
+        second.subscribe("b", predicate);
+        slow.subscribe("c", predicate);
+        ok = wait_for_subscribers(server, "a", 1) && wait_for_subscribers(server, "b", 2) && wait_for_subscribers(server, "c", 1);
+
+        ok = ok && server.publish("a", (int32_t)1, std::string("x")) == 1 && server.publish("b", (int32_t)2) == 2 && server.publish("d", (int32_t)3) == 0;
+
+        ipc::in_message msg;
+        int32_t i = 0;
+        std::string s;
+        ok = ok && first.receive(msg, predicate) == "a";
+        msg >> i >> s;
+        ok = ok && i == 1 && s == "x";
+        ok = ok && first.receive(msg, predicate) == "b";
+        msg >> i;
+        ok = ok && i == 2;
+        ok = ok && second.receive(msg, predicate) == "b"; // topic "a" is not delivered to the second client
+        msg >> i;
+        ok = ok && i == 2;
+
+        // slow subscriber doesn't read, so its queue overflows and publications are dropped
+        const std::vector<uint8_t> payload(32768, 0x5A);
+        size_t published = 0;
+        while (published < 10000 && server.publish("c", std::make_pair(payload.data(), payload.size())) == 1)
+            ++published;
+
+        ok = ok && published < 10000 && server.get_dropped_count() > 0;
+
+        std::vector<uint8_t> blob;
+        for (size_t n = 0; n < published; ++n)
+        {
+            ok = ok && slow.receive(msg, predicate) == "c";
+            msg >> blob;
+            ok = ok && blob == payload;
+        }
+
+        server.publish("c", std::make_pair(payload.data(), payload.size()));
+        ok = ok && slow.receive(msg, predicate) == "c" && slow.get_dropped_count() == server.get_dropped_count();
+
+        second.unsubscribe("b", predicate);
+        ok = ok && wait_for_subscribers(server, "b", 1);
+    }
+    catch (const std::exception&)
+    {
+        ok = false;
+    }
+
+    g_stop = true;
+    server_thread.join();
+    return ok && h.get_errors_count() == 0 ? 0 : 1;
+}
@@ -0,0 +1,49 @@
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "recorder.hpp"
+
+static std::string dump()
+{
+    std::string text;
+    std::FILE* file = std::tmpfile();
+    if (file == nullptr)
+        return text;
+
+    ipc::dump_flight_recorder(fileno(file));
+    std::rewind(file);
+
+    char buffer[4096];
+    for (size_t size = 0; (size = std::fread(buffer, 1, sizeof(buffer), file)) != 0;)
+        text.append(buffer, size);
+
+    std::fclose(file);
+    return text;
+}
+
+int main()
+{
+    ipc::record_flight_event(ipc::flight_event::accept);
+    ipc::record_flight_event(ipc::flight_event::dispatch_start, 42);
+
+    std::thread([]
+        {
+            for (int i = 0; i < 5000; ++i) // ring is overwritten
+                ipc::record_flight_event(ipc::flight_event::call_start, 7);
+        }).join();
+
+    const std::string text = dump();
+    bool ok = text.find("thread=1 ") != std::string::npos && text.find("event=accept value=0\n") != std::string::npos;
+    ok = ok && text.find("event=dispatch_start value=42\n") != std::string::npos;
+    ok = ok && text.find("event=accept") < text.find("event=dispatch_start"); // the oldest events first
+    ok = ok && std::count(text.begin(), text.end(), '\n') == 2 + 2047;
+
+    std::thread([] { ipc::record_flight_event(ipc::flight_event::error, 1); }).join(); // ring of finished thread is reused without its events
+    const std::string reused = dump();
+    ok = ok && std::count(reused.begin(), reused.end(), '\n') == 2 + 1 && reused.find("thread=3 ") != std::string::npos;
+    ok = ok && reused.find("event=error value=1\n") != std::string::npos && reused.find("event=call_start") == std::string::npos;
+
+    return ok ? 0 : 1;
+}
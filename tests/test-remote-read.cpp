@@ -0,0 +1,87 @@
+#include <atomic>
+#include <csignal>
+#include <thread>
+#include <tuple>
+
+#include "rpc.hpp"
+
+static std::atomic<bool> g_stop = false;
+static auto predicate = [] { return !g_stop; };
+
+struct point
+{
+    int32_t x;
+    int64_t y;
+    double z;
+};
+
+class dispatcher
+{
+public:
+    void invoke(uint32_t id, ipc::in_message& in_msg, ipc::out_message& out_msg, ipc::point_to_point_socket& p2p_socket) const
+    {
+        auto read = [&](const ipc::message::remote_ptr<true>& p, size_t offset)
+        {
+            const char* base = (const char*)p.get_pointer();
+            auto [x, y, z] = ipc::service_invoker().read_by_channel<int32_t, int64_t, double>(p2p_socket, in_msg, out_msg, predicate,
+                ipc::message::remote_ptr<true>(base + offset + offsetof(point, x)), ipc::message::remote_ptr<true>(base + offset + offsetof(point, y)),
+                ipc::message::remote_ptr<true>(base + offset + offsetof(point, z)));
+            return (double)x + (double)y + z;
+        };
+
+        if (id == 1) // all values are inside the argument
+            ipc::function_invoker<double(ipc::message::remote_ptr<true>), true>()(in_msg, out_msg, [&](const ipc::message::remote_ptr<true>& p) { return read(p, 0); });
+        else if (id == 2) // values after the argument are requested
+            ipc::function_invoker<double(ipc::message::remote_ptr<true>), true>()(in_msg, out_msg, [&](const ipc::message::remote_ptr<true>& p) { return read(p, sizeof(point)); });
+    }
+
+    void report_error(const std::exception_ptr&) const {}
+    void ready() const {}
+};
+
+static bool client_dispatch(uint32_t, ipc::in_message&, ipc::out_message&)
+{
+    return false;
+}
+
+int main()
+{
+    signal(SIGPIPE, SIG_IGN);
+
+    const char* path = "test-remote-read.sock";
+    ipc::rpc_server<ipc::unix_server_socket> server(path);
+    std::thread server_thread([&server] { server.run(dispatcher(), predicate); });
+
+    point points[2] = { { 1, 20, 0.5 }, { 1000, 2000, 3000.0 } };
+    bool ok = true;
+    try
+    {
+        ok = ipc::service_invoker().call_by_address<1, double>(std::tuple{ path }, client_dispatch, predicate, ipc::readable_ptr(&points[0])) == 21.5;
+    }
+    catch (const std::exception&)
+    {
+        ok = false;
+    }
+
+    auto rejected = [&](const auto& arg)
+    {
+        try
+        {
+            ipc::service_invoker().call_by_address<2, double>(std::tuple{ path }, client_dispatch, predicate, arg);
+        }
+        catch (const ipc::bad_message_exception&)
+        {
+            return true;
+        }
+        catch (const std::exception&) {}
+
+        return false;
+    };
+
+    ok = ok && rejected(ipc::readable_ptr(&points[0])); // the second point is not readable
+    ok = ok && rejected(ipc::message::remote_ptr<true>(&points[0])); // plain remote pointers are not readable
+
+    g_stop = true;
+    server_thread.join();
+    return ok ? 0 : 1;
+}
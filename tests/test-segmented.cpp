@@ -0,0 +1,49 @@
+#include <string>
+#include <thread>
+
+#include "ipc.hpp"
+
+int main()
+{
+    const std::string long_string(ipc::segmented_out_message::segment_size + 100, 'x');
+    const uint8_t bytes[] = { 1, 2, 3 };
+
+    ipc::out_message out;
+    out << (uint32_t)1 << long_string << std::make_pair(bytes, sizeof(bytes)) << 2.5;
+
+    ipc::segmented_out_message segmented;
+    segmented << (uint32_t)1 << long_string << std::make_pair(bytes, sizeof(bytes)) << 2.5;
+
+    ipc::message_buffer flat;
+    segmented.flatten(flat);
+    bool ok = segmented.get_segments_count() == 2 && segmented.size() == out.get_data().size();
+    ok = ok && std::string(flat.begin(), flat.end()) == std::string(out.get_data().begin(), out.get_data().end());
+
+    segmented.clear();
+    segmented << (uint32_t)3;
+    ok = ok && segmented.get_segments_count() == 1;
+
+    // vectored write is read as ordinary message
+    const std::string path = "test-segmented.sock";
+    ipc::unix_server_socket server(path);
+    std::thread client([&]
+    {
+        ipc::unix_client_socket socket(path);
+        ipc::segmented_out_message msg;
+        msg << long_string << (uint32_t)4;
+        socket.write_message(msg, [] { return true; });
+        socket.wait_for_shutdown([] { return true; });
+    });
+
+    auto socket = server.accept([] { return true; });
+    ipc::in_message in;
+    std::string s;
+    uint32_t u = 0;
+    ok = ok && socket.read_message(in, [] { return true; });
+    in >> s >> u;
+    ok = ok && s == long_string && u == 4;
+    socket.shutdown();
+    client.join();
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,32 @@
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "slowlog.hpp"
+
+int main()
+{
+    const std::string path = "test-slowlog.log";
+    bool ok = true;
+    {
+        ipc::slow_call_log log(path, std::chrono::milliseconds(10), 2, 4);
+
+        ipc::slow_call call;
+        call.function = 7;
+        call.read = 1000;
+        call.dispatch = 20000000;
+        call.write = 3000;
+        call.payload_size = 6;
+        call.payload = std::string("\x01\xAB\x00\x10\xFF\x02", 6);
+        ok = log.submit(ipc::slow_call(call)) && log.submit(ipc::slow_call(call));
+        ok = ok && !log.submit(std::move(call)) && log.get_dropped_count() == 1; // rate limit
+    }
+
+    std::ifstream file(path);
+    const std::string text{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    ok = ok && std::count(text.begin(), text.end(), '\n') == 2;
+    ok = ok && text.find("function=7 total=20004000 read=1000 dispatch=20000000 write=3000 payload=6 dump=01ab0010 dropped=0\n") != std::string::npos;
+
+    return ok ? 0 : 1;
+}
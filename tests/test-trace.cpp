@@ -0,0 +1,58 @@
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "ipc.hpp"
+
+int main()
+{
+    const auto root = ipc::trace_context::start();
+
+    ipc::out_message out_msg;
+    out_msg.set_trace_context(root);
+    out_msg << (uint32_t)42;
+
+    ipc::in_message in_msg;
+    std::copy(out_msg.get_data().begin(), out_msg.get_data().end(), in_msg.get_data().begin());
+
+    uint32_t value = 0;
+    in_msg >> value;
+    const auto received = in_msg.get_trace_context();
+    bool ok = (value == 42 && received.trace_id == root.trace_id && received.span_id == root.span_id && received.is_sampled());
+    ok = ok && (in_msg.get_payload().size() == out_msg.get_payload().size());
+
+    ipc::trace_context child;
+    {
+        ipc::span_scope server(ipc::span_kind::server, 7, received);
+        child = ipc::get_current_trace_context();
+        ok = ok && child.trace_id == root.trace_id && child.span_id != root.span_id;
+        server.mark_read();
+        server.mark_dispatched();
+    }
+
+    ok = ok && ipc::get_current_trace_context().trace_id == 0; // previous context is restored
+
+    std::thread([] { ipc::span_scope client(ipc::span_kind::client, 8, ipc::trace_context()); }).join(); // not sampled
+
+    std::ostringstream dump;
+    ipc::dump_spans(dump);
+    const std::string text = dump.str();
+    ok = ok && std::count(text.begin(), text.end(), '\n') == 1 && text.find("kind=server function=7") != std::string::npos;
+
+    std::ostringstream parent;
+    parent << "parent=" << std::hex << std::setfill('0') << std::setw(16) << root.span_id;
+    ok = ok && text.find(parent.str()) != std::string::npos;
+
+    for (uint32_t function = 100; function < 110; ++function) // rings of finished threads are reused
+        std::thread([&received, function] { ipc::span_scope server(ipc::span_kind::server, function, received); }).join();
+
+    std::ostringstream reused;
+    ipc::dump_spans(reused);
+    const std::string spans = reused.str();
+    ok = ok && std::count(spans.begin(), spans.end(), '\n') == 11 && spans.find("function=109") != std::string::npos;
+    ok = ok && ipc::get_span_registry().rings.size() == 2;
+
+    return ok ? 0 : 1;
+}
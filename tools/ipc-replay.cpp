@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <clocale>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/capture.hpp"
+
+/*
+    Replays requests captured by ipc::rpc_server::enable_capture to the server.
+
+    Each captured connection is replayed as a conversation: the first message read by the capturing server is sent as request,
+    after each received message (callback or response) the next captured read message (callback answer) is sent. Conversations
+    are started with original intervals divided by speed factor (zero speed means "as fast as possible").
+*/
+
+struct conversation
+{
+    int64_t start = 0;
+    std::vector<std::string> messages;
+};
+
+static std::vector<conversation> load_conversations(const char* path)
+{
+    std::map<uint64_t, conversation> connections;
+    ipc::capture_reader reader(path);
+    ipc::capture_record r;
+    while (reader.next(r))
+    {
+        if (r.written)
+            continue;
+
+        auto& c = connections[r.connection_id];
+        if (c.messages.empty())
+            c.start = r.timestamp;
+
+        c.messages.emplace_back(r.message);
+    }
+
+    std::vector<conversation> result;
+    for (auto& [id, c] : connections)
+        result.push_back(std::move(c));
+
+    std::sort(result.begin(), result.end(), [](const conversation& a, const conversation& b) { return a.start < b.start; });
+    return result;
+}
+
+static auto predicate = []() { return true; };
+
+static void replay(const conversation& c, const char* host, uint16_t port)
+{
+    ipc::tcp_client_socket socket(host, port);
+    ipc::in_message in_msg;
+    for (const auto& message : c.messages)
+    {
+        socket.write_message(message.data(), predicate);
+        socket.read_message(in_msg, predicate);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4)
+    {
+        std::cout << "usage: ipc-replay <capture log> <host> <port> [speed factor (default 1, 0 - no delays)] [threads count]" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        std::setlocale(LC_ALL, "");
+
+        const char* host = argv[2];
+        const uint16_t port = (uint16_t)std::atoi(argv[3]);
+        const double speed = (argc > 4) ? std::atof(argv[4]) : 1.0;
+        const unsigned int threads_count = (argc > 5) ? (unsigned int)std::atoi(argv[5]) : std::thread::hardware_concurrency();
+
+        const auto conversations = load_conversations(argv[1]);
+        if (conversations.empty())
+        {
+            std::cout << "there are no captured requests" << std::endl;
+            return 0;
+        }
+
+        std::vector<int64_t> latencies(conversations.size());
+        std::atomic<size_t> next = 0;
+        std::atomic<size_t> errors = 0;
+        const auto replay_start = std::chrono::steady_clock::now();
+        auto worker = [&]()
+        {
+            for (size_t i = next++; i < conversations.size(); i = next++)
+            {
+                const auto& c = conversations[i];
+                if (speed > 0)
+                    std::this_thread::sleep_until(replay_start + std::chrono::nanoseconds((int64_t)((c.start - conversations.front().start) / speed)));
+
+                const auto start = std::chrono::steady_clock::now();
+                try
+                {
+                    replay(c, host, port);
+                }
+                catch (const std::exception& ex)
+                {
+                    if (errors++ == 0)
+                        std::cout << "replay error >> " << ex.what() << std::endl;
+                }
+
+                latencies[i] = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (unsigned int i = 0; i < std::max(threads_count, 1u); ++i)
+            workers.emplace_back(worker);
+
+        for (auto& w : workers)
+            w.join();
+
+        const auto total = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - replay_start).count();
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&latencies](double p) { return latencies[std::min(latencies.size() - 1, (size_t)(p * latencies.size()))]; };
+
+        std::cout << "conversations: " << conversations.size() << ", errors: " << errors << ", time: " << total << " ms" << std::endl;
+        std::cout << "latency (us): p50 " << percentile(0.5) << ", p99 " << percentile(0.99) << ", max " << latencies.back() << std::endl;
+    }
+    catch (const std::exception& ex)
+    {
+        std::cout << "fatal error >> " << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <clocale>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <tuple>
+
+#include "../include/rpc.hpp"
+
+/*
+    Queries metrics of ipc::rpc_server (see ipc::rpc_server::enable_metrics) and prints them.
+*/
+
+static auto predicate = []() { return true; };
+
+static std::string format_time(uint64_t ns)
+{
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(1);
+    if (ns >= 1000000000)
+        stream << ns / 1e9 << " s";
+    else if (ns >= 1000000)
+        stream << ns / 1e6 << " ms";
+    else if (ns >= 1000)
+        stream << ns / 1e3 << " us";
+    else
+        stream << ns << " ns";
+
+    return stream.str();
+}
+
+static void print(const ipc::metrics_snapshot& s)
+{
+    const double utilization = (s.workers != 0 && s.uptime != 0) ? 100.0 * s.busy_time / ((double)s.workers * s.uptime) : 0.0;
+
+    std::cout << "uptime:             " << format_time(s.uptime) << std::endl;
+    std::cout << "workers:            " << s.workers << " (utilization " << std::fixed << std::setprecision(1) << utilization << "%)" << std::endl;
+    std::cout << "active connections: " << s.active_connections << std::endl;
+    std::cout << "connections:        " << s.connections << " (errors " << s.errors << ")" << std::endl;
+    std::cout << "cache memory:       " << s.cache_memory << " bytes" << std::endl;
+    if (s.untracked_calls != 0)
+        std::cout << "untracked calls:    " << s.untracked_calls << std::endl;
+
+    if (s.functions.empty())
+        return;
+
+    std::cout << std::endl << std::left << std::setw(12) << "function" << std::right << std::setw(10) << "calls" << std::setw(12) << "mean" << std::setw(12) << "p50"
+        << std::setw(12) << "p99" << std::setw(12) << "max" << std::endl;
+
+    for (const auto& f : s.functions)
+    {
+        std::cout << std::left << std::setw(12) << (f.function == ipc::function_invoker_base::metrics_id ? std::string("metrics") : std::to_string(f.function))
+            << std::right << std::setw(10) << f.calls << std::setw(12) << format_time(f.calls != 0 ? f.total / f.calls : 0) << std::setw(12) << format_time(f.p50)
+            << std::setw(12) << format_time(f.p99) << std::setw(12) << format_time(f.max) << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "usage: ipc-stats <host> <port> | ipc-stats <unix socket path>" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        std::setlocale(LC_ALL, "");
+
+        ipc::service_invoker invoker;
+        if (argc > 2)
+            print(invoker.query_metrics(std::make_tuple(std::string(argv[1]), (uint16_t)std::atoi(argv[2])), predicate));
+        else
+            print(invoker.query_metrics(std::make_tuple(std::string(argv[1])), predicate));
+    }
+    catch (const std::exception& ex)
+    {
+        std::cout << "error >> " << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}